@@ -0,0 +1,127 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+#include "GameState.hpp"
+#include "Utils.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define ATTACK_MAP_X86
+#endif
+
+// Every square one side attacks, computed for whole piece sets at once: shifts for pawns,
+// knights and kings, Kogge-Stone occluded fills for sliders (three shift-and-mask steps
+// cover a whole ray). No square is looked up on its own, so this is for the questions
+// about the full map (NodeAttacks threats); a single square is cheaper through GetAttack.
+// The AVX2 kernel runs four slider directions per vector, it is picked once at startup.
+class AttackMap final {
+public:
+    using Kernel = Bitboard (*)(Bitboard diagonal, Bitboard orthogonal, Bitboard empty) noexcept;
+
+    // Sliders see through the pieces in `transparent`, as if those squares were empty.
+    template <EnumColor Color>
+    [[nodiscard]] static inline Bitboard Of(const GameState& Board, bool with_king = true,
+                                           Bitboard transparent = 0ULL) noexcept {
+        const auto own     = Board[Color];
+        const auto queens  = Board[Queens] & own;
+        const auto attacks = PawnAttacks<Color>(Board[Pawns] & own)
+                           | KnightAttacks(Board[Knights] & own)
+                           | Sliders((Board[Bishops] & own) | queens, (Board[Rooks] & own) | queens,
+                                     ~(Board[White] | Board[Black]) | transparent);
+        return with_king ? attacks | KingAttacks(Board[King] & own) : attacks;
+    }
+
+    template <EnumColor Color>
+    [[nodiscard]] static constexpr inline Bitboard PawnAttacks(Bitboard pawns) noexcept {
+        constexpr auto Up = Color == White ? North : South;
+        return Utils::ShiftTo<Up|East>(pawns) | Utils::ShiftTo<Up|West>(pawns);
+    }
+
+    [[nodiscard]] static constexpr inline Bitboard KnightAttacks(Bitboard knights) noexcept {
+        return Utils::ShiftTo<North|North|West>(knights) | Utils::ShiftTo<North|North|East>(knights)
+             | Utils::ShiftTo<South|South|West>(knights) | Utils::ShiftTo<South|South|East>(knights)
+             | Utils::ShiftTo<North| West|West>(knights) | Utils::ShiftTo<North| East|East>(knights)
+             | Utils::ShiftTo<South| West|West>(knights) | Utils::ShiftTo<South| East|East>(knights);
+    }
+
+    [[nodiscard]] static constexpr inline Bitboard KingAttacks(Bitboard kings) noexcept {
+        const auto sides = Utils::ShiftTo<East>(kings) | Utils::ShiftTo<West>(kings) | kings;
+        return (sides | (sides << 8) | (sides >> 8)) ^ kings;
+    }
+
+    // Bishop-like and rook-like sliders (queens go in both) through the empty squares.
+    [[nodiscard]] static inline Bitboard Sliders(Bitboard diagonal, Bitboard orthogonal, Bitboard empty) noexcept {
+        return Dispatch(diagonal, orthogonal, empty);
+    }
+
+    [[nodiscard]] static inline const char* Name() noexcept {
+        return Dispatch == Scalar ? "scalar" : "avx2";
+    }
+
+    // Reference path, also what every non-x86 build runs.
+    static inline Bitboard Scalar(Bitboard diagonal, Bitboard orthogonal, Bitboard empty) noexcept {
+        return Slide<North     >(orthogonal, empty) | Slide<South     >(orthogonal, empty)
+             | Slide<East      >(orthogonal, empty) | Slide<West      >(orthogonal, empty)
+             | Slide<North|East>(diagonal,   empty) | Slide<North|West>(diagonal,   empty)
+             | Slide<South|East>(diagonal,   empty) | Slide<South|West>(diagonal,   empty);
+    }
+
+    #if defined(ATTACK_MAP_X86)
+    // Lanes are N, E, NE, NW for the left shifts and S, W, SW, SE for the right ones: the
+    // same shift amounts and wrap masks as Slide, one direction per 64-bit lane.
+    __attribute__((target("avx2")))
+    static inline Bitboard AVX2(Bitboard diagonal, Bitboard orthogonal, Bitboard empty) noexcept {
+        const auto shift     = _mm256_setr_epi64x(8, 1, 9, 7);
+        const auto not_a     = std::int64_t(~Bitboard(File_A)), not_h = std::int64_t(~Bitboard(File_H));
+        const auto wrap_up   = _mm256_setr_epi64x(-1, not_a, not_a, not_h);
+        const auto wrap_down = _mm256_setr_epi64x(-1, not_h, not_h, not_a);
+        const auto sliders   = _mm256_setr_epi64x(std::int64_t(orthogonal), std::int64_t(orthogonal),
+                                                  std::int64_t(diagonal),   std::int64_t(diagonal));
+        const auto space     = _mm256_set1_epi64x(std::int64_t(empty));
+
+        auto up = sliders, down = sliders;
+        auto pro_up = _mm256_and_si256(space, wrap_up), pro_down = _mm256_and_si256(space, wrap_down);
+        auto step = shift;
+        for (auto round = 0; round < 3; ++round, step = _mm256_add_epi64(step, step)) {
+            up   = _mm256_or_si256(up,   _mm256_and_si256(pro_up,   _mm256_sllv_epi64(up,   step)));
+            down = _mm256_or_si256(down, _mm256_and_si256(pro_down, _mm256_srlv_epi64(down, step)));
+            pro_up   = _mm256_and_si256(pro_up,   _mm256_sllv_epi64(pro_up,   step));
+            pro_down = _mm256_and_si256(pro_down, _mm256_srlv_epi64(pro_down, step));
+        }
+        const auto rays = _mm256_or_si256(_mm256_and_si256(_mm256_sllv_epi64(up,   shift), wrap_up),
+                                          _mm256_and_si256(_mm256_srlv_epi64(down, shift), wrap_down));
+        const auto half = _mm_or_si128(_mm256_castsi256_si128(rays), _mm256_extracti128_si256(rays, 1));
+        return Bitboard(_mm_cvtsi128_si64(_mm_or_si128(half, _mm_unpackhi_epi64(half, half))));
+    }
+    #endif
+
+private:
+    // Kogge-Stone: `sliders` spread along `Direction` through `empty`, then one more step
+    // onto the first blocker. Squares that would wrap around the board are masked out.
+    template <EnumCompass Direction>
+    [[nodiscard]] static constexpr inline Bitboard Slide(Bitboard sliders, Bitboard empty) noexcept {
+        constexpr auto Wrap = (Direction + 16) % 8 == 1 ? ~Bitboard(File_A)
+                            : (Direction + 16) % 8 == 7 ? ~Bitboard(File_H) : ~Bitboard(0);
+        const auto Step = [](Bitboard set, int times) {
+            return Direction > 0 ? set << (Direction * times) : set >> (-Direction * times);
+        };
+        empty &= Wrap;
+        sliders |= empty & Step(sliders, 1); empty &= Step(empty, 1);
+        sliders |= empty & Step(sliders, 2); empty &= Step(empty, 2);
+        sliders |= empty & Step(sliders, 4);
+        return Step(sliders, 1) & Wrap;
+    }
+
+    static inline Kernel Select() noexcept {
+        #if defined(ATTACK_MAP_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return AVX2;
+        #endif
+        return Scalar;
+    }
+
+    static inline const Kernel Dispatch = Select();
+
+     AttackMap()=delete;
+    ~AttackMap()=delete;
+};
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+
+#include <atomic>
+#include <memory>
+#include <cstdint>
+#include <algorithm>
+
+#define EVAL_CACHE_KB     256
+#define EVAL_CACHE_MAX_KB (1 << 20)
+
+// Static evaluations by Zobrist hash, shared by every search thread. One direct-mapped
+// slot per hash, each a single 64-bit word written and read in one go, like the
+// transposition table: no locks, a racing reader sees an old entry or a miss.
+//
+//  63                                             16 15            0
+// ┌─────────────────────────────────────────────────┬───────────────┐
+// │              low 48 bits of the hash            │     score     │
+// └─────────────────────────────────────────────────┴───────────────┘
+//
+// The slot is picked from the high bits, the check uses the low ones.
+class EvalCache final {
+public:
+    [[nodiscard]] static inline bool Probe(std::uint64_t hash, int& score) noexcept {
+        if (!entries) return false;
+        ++probes;
+        const auto data = Slot(hash).load(std::memory_order_relaxed);
+        if ((data & ~0xFFFFULL) != (hash << 16)) return false;
+        ++hits; score = std::int16_t(data);
+        return true;
+    }
+
+    static inline void Store(std::uint64_t hash, int score) noexcept {
+        if (!entries) return;
+        Slot(hash).store((hash << 16) | std::uint16_t(score), std::memory_order_relaxed);
+    }
+
+    // Size in kilobytes so it can be matched to a cache level, 0 disables the cache.
+    static inline void Resize(std::size_t kb) noexcept {
+        kb = std::min<std::size_t>(kb, EVAL_CACHE_MAX_KB);
+        entries = (kb << 10) / sizeof(std::uint64_t);
+        table.reset(entries ? new std::atomic<std::uint64_t>[entries] : nullptr);
+        Clear();
+    }
+
+    static inline void Clear() noexcept {
+        for (std::size_t index = 0; index < entries; ++index)
+            table[index].store(0, std::memory_order_relaxed);
+    }
+
+    //////////////////////////////////////// STATISTICS ////////////////////////////////////////
+
+    // Counted per thread, folded into the totals when a thread is done searching.
+    static inline thread_local std::uint64_t probes, hits;
+
+    static inline void Flush() noexcept {
+        total_probes.fetch_add(probes, std::memory_order_relaxed);
+        total_hits  .fetch_add(hits,   std::memory_order_relaxed);
+        probes = hits = 0;
+    }
+
+    static inline void ResetStatistics() noexcept {
+        probes = hits = 0;
+        total_probes = total_hits = 0;
+    }
+
+    // Permille, like hashfull.
+    [[nodiscard]] static inline int HitRate() noexcept {
+        const auto total = total_probes.load(std::memory_order_relaxed);
+        return total ? int(total_hits.load(std::memory_order_relaxed) * 1000 / total) : 0;
+    }
+
+    [[nodiscard]] static inline std::uint64_t Probes() noexcept {
+        return total_probes.load(std::memory_order_relaxed);
+    }
+
+private:
+    static inline std::unique_ptr<std::atomic<std::uint64_t>[]> table;
+    static inline std::size_t                                   entries = 0;
+
+    static inline std::atomic<std::uint64_t> total_probes = 0, total_hits = 0;
+
+    [[nodiscard]] static inline std::atomic<std::uint64_t>& Slot(std::uint64_t hash) noexcept {
+        return table[(static_cast<unsigned __int128>(hash) * entries) >> 64];
+    }
+
+     EvalCache()=delete;
+    ~EvalCache()=delete;
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+#include "Utils.hpp"
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define EVAL_KERNELS_X86
+#endif
+
+// Every minor and major piece of one side, at most 15 of them (promotions included),
+// padded with empty sets up to a multiple of the widest kernel's 4 lanes.
+#define ATTACK_BATCH_SIZE 16
+
+struct alignas(32) AttackBatch {
+    std::array<Bitboard,  ATTACK_BATCH_SIZE> attacks { };
+    std::array<EnumPiece, ATTACK_BATCH_SIZE> pieces  { };
+    int size = 0;
+};
+
+// Per-piece popcounts for the evaluation: squares reached inside the mobility area and
+// inside the enemy king zone. One call covers a whole side, the AVX2 kernel does four
+// bitboards per step with a nibble lookup popcount. The kernel is picked once at startup
+// from the CPU the binary runs on, so a portable build still gets the vector path.
+class EvalKernels final {
+public:
+    using Counts = std::array<std::uint8_t, ATTACK_BATCH_SIZE>;
+    using Kernel = void (*)(const AttackBatch&, Bitboard, Bitboard, Counts&, Counts&) noexcept;
+
+    static inline void Count(const AttackBatch& Batch, Bitboard area, Bitboard zone,
+                             Counts& mobility, Counts& attacks) noexcept {
+        Dispatch(Batch, area, zone, mobility, attacks);
+    }
+
+    [[nodiscard]] static inline const char* Name() noexcept {
+        return Dispatch == Scalar ? "scalar" : "avx2";
+    }
+
+    // Reference path, also what every non-x86 build runs.
+    static inline void Scalar(const AttackBatch& Batch, Bitboard area, Bitboard zone,
+                              Counts& mobility, Counts& attacks) noexcept {
+        for (auto i = 0; i < Batch.size; ++i) {
+            mobility[i] = Utils::PopCount(Batch.attacks[i] & area);
+            attacks [i] = Utils::PopCount(Batch.attacks[i] & zone);
+        }
+    }
+
+    #if defined(EVAL_KERNELS_X86)
+    __attribute__((target("avx2")))
+    static inline void AVX2(const AttackBatch& Batch, Bitboard area, Bitboard zone,
+                            Counts& mobility, Counts& attacks) noexcept {
+        const auto area4 = _mm256_set1_epi64x(std::int64_t(area));
+        const auto zone4 = _mm256_set1_epi64x(std::int64_t(zone));
+        // Byte 0 of each 64-bit count is moved to bytes 0-1 (mobility) and 2-3 (king zone)
+        // of each 128-bit half, then both halves are joined in the low 64 bits.
+        const auto gather = _mm256_setr_epi8(0, 8, 4, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+                                             0, 8, 4, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1);
+        const auto join   = _mm256_setr_epi32(0, 4, 0, 0, 0, 0, 0, 0);
+        for (auto i = 0; i < Batch.size; i += 4) {
+            const auto set    = _mm256_load_si256(reinterpret_cast<const __m256i*>(&Batch.attacks[i]));
+            const auto counts = _mm256_or_si256(PopCount4(_mm256_and_si256(set, area4)),
+                _mm256_slli_epi64(PopCount4(_mm256_and_si256(set, zone4)), 32));
+            const auto packed = std::uint64_t(_mm_cvtsi128_si64(_mm256_castsi256_si128(
+                _mm256_permutevar8x32_epi32(_mm256_shuffle_epi8(counts, gather), join))));
+            const auto m = std::uint32_t((packed & 0xffff) | ((packed >> 16) & 0xffff0000));
+            const auto a = std::uint32_t(((packed >> 16) & 0xffff) | ((packed >> 32) & 0xffff0000));
+            std::memcpy(&mobility[i], &m, sizeof(m));
+            std::memcpy(&attacks [i], &a, sizeof(a));
+        }
+    }
+    #endif
+
+private:
+    #if defined(EVAL_KERNELS_X86)
+    // Popcount of each 64-bit lane: per-byte counts from a nibble table, summed by psadbw.
+    __attribute__((target("avx2")))
+    static inline __m256i PopCount4(__m256i bitboards) noexcept {
+        const auto lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4,
+                                             0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+        const auto nibble = _mm256_set1_epi8(0x0f);
+        const auto lo = _mm256_shuffle_epi8(lookup, _mm256_and_si256(bitboards, nibble));
+        const auto hi = _mm256_shuffle_epi8(lookup, _mm256_and_si256(_mm256_srli_epi64(bitboards, 4), nibble));
+        return _mm256_sad_epu8(_mm256_add_epi8(lo, hi), _mm256_setzero_si256());
+    }
+    #endif
+
+    static inline Kernel Select() noexcept {
+        #if defined(EVAL_KERNELS_X86)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) return AVX2;
+        #endif
+        return Scalar;
+    }
+
+    static inline const Kernel Dispatch = Select();
+
+     EvalKernels()=delete;
+    ~EvalKernels()=delete;
+};
@@ -2,157 +2,119 @@
 
 #include "ChessEngine.hpp"
 #include "MoveGeneration.hpp"
+#include "PieceSquare.hpp"
+#include "NNUE.hpp"
+#include "EvalKernels.hpp"
+#include "PawnHash.hpp"
+#include "EvalCache.hpp"
+#include "GetAttack.hpp"
 
-template <EnumColor Color>
-constexpr inline std::array<std::array<int, 64>, 6> PieceSquareScore{};
-
-template <>
-constexpr inline std::array<std::array<int, 64>, 6> PieceSquareScore<White> {
-    {
-    { // PAWNS
-        0,   0,   0,   0,   0,   0,   0,   0,
-        0,   0,   0, -10, -10,   0,   0,   0,
-        0,   0,   0,   5,   5,   0,   0,   0,
-        5,   5,  10,  20,  20,   5,   5,   5,
-        10,  10,  10,  20,  20,  10,  10,  10,
-        20,  20,  20,  30,  30,  30,  20,  20,
-        30,  30,  30,  40,  40,  30,  30,  30,
-        90,  90,  90,  90,  90,  90,  90,  90,
-    },
-
-    { // KNIGHTS
-        -5, -10,   0,   0,   0,   0, -10,  -5
-        -5,   0,   0,   0,   0,   0,   0,  -5,
-        -5,   5,  20,  10,  10,  20,   5,  -5,
-        -5,  10,  20,  30,  30,  20,  10,  -5,
-        -5,  10,  20,  30,  30,  20,  10,  -5,
-        -5,   5,  20,  20,  20,  20,   5,  -5,
-        -5,   0,   0,  10,  10,   0,   0,  -5,
-        -5,   0,   0,   0,   0,   0,   0,  -5,
-
-    },
-
-    { // BISHOPS
-        0,   0, -10,   0,   0, -10,   0,   0,
-        0,  30,   0,   0,   0,   0,  30,   0,
-        0,  10,   0,   0,   0,   0,  10,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,   0,  10,  10,   0,   0,   0,
-        0,   0,   0,   0,   0,   0,   0,   0,
-        0,   0,   0,   0,   0,   0,   0,   0,
-    },
-
-    { // ROOKS
-        0,   0,   0,  20,  20,   0,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        50,  50,  50,  50,  50,  50,  50,  50,
-        50,  50,  50,  50,  50,  50,  50,  50,
-    },
-
-    { }, // QUEENS
-
-    { // KING
-        0,   0,   5,   0, -15,   0,  10,   0,
-        0,   5,   5,  -5,  -5,   0,   5,   0,
-        0,   0,   5,  10,  10,   5,   0,   0,
-        0,   5,  10,  20,  20,  10,   5,   0,
-        0,   5,  10,  20,  20,  10,   5,   0,
-        0,   5,   5,  10,  10,   5,   5,   0,
-        0,   0,   5,   5,   5,   5,   0,   0,
-        0,   0,   0,   0,   0,   0,   0,   0,
-    }
-    }
-};
-
-template <>
-constexpr inline std::array<std::array<int, 64>, 6> PieceSquareScore<Black> {
-    {
-    { // PAWNS
-        90,  90,  90,  90,  90,  90,  90,  90,
-        30,  30,  30,  40,  40,  30,  30,  30,
-        20,  20,  20,  30,  30,  30,  20,  20,
-        10,  10,  10,  20,  20,  10,  10,  10,
-        5,   5,  10,  20,  20,   5,   5,   5,
-        0,   0,   0,   5,   5,   0,   0,   0,
-        0,   0,   0, -10, -10,   0,   0,   0,
-        0,   0,   0,   0,   0,   0,   0,   0
-    },
-
-    { // KNIGHTS
-        -5,   0,   0,   0,   0,   0,   0,  -5,
-        -5,   0,   0,  10,  10,   0,   0,  -5,
-        -5,   5,  20,  20,  20,  20,   5,  -5,
-        -5,  10,  20,  30,  30,  20,  10,  -5,
-        -5,  10,  20,  30,  30,  20,  10,  -5,
-        -5,   5,  20,  10,  10,  20,   5,  -5,
-        -5,   0,   0,   0,   0,   0,   0,  -5,
-        -5, -10,   0,   0,   0,   0, -10,  -5
-
-    },
-
-    { // BISHOPS
-        0,   0,   0,   0,   0,   0,   0,   0,
-        0,   0,   0,   0,   0,   0,   0,   0,
-        0,   0,   0,  10,  10,   0,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,  10,   0,   0,   0,   0,  10,   0,
-        0,  30,   0,   0,   0,   0,  30,   0,
-        0,   0, -10,   0,   0, -10,   0,   0
-    },
-
-    { // ROOKS
-        50,  50,  50,  50,  50,  50,  50,  50,
-        50,  50,  50,  50,  50,  50,  50,  50,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,  10,  20,  20,  10,   0,   0,
-        0,   0,   0,  20,  20,   0,   0,   0
-    },
-
-    { },// QUEENS
-
-    { // KING
-        0,   0,   0,   0,   0,   0,   0,   0,
-        0,   0,   5,   5,   5,   5,   0,   0,
-        0,   5,   5,  10,  10,   5,   5,   0,
-        0,   5,  10,  20,  20,  10,   5,   0,
-        0,   5,  10,  20,  20,  10,   5,   0,
-        0,   0,   5,  10,  10,   5,   0,   0,
-        0,   5,   5,  -5,  -5,   0,   5,   0,
-        0,   0,   5,   0, -15,   0,  10,   0
-    }}
-};
+#include <cassert>
 
+// Material and piece-square terms are kept up to date by Move::Make, mobility and king
+// safety are computed at each call. Define DEBUG_INCREMENTAL_EVAL to check the running
+// terms against a full recomputation at every leaf.
+// #define DEBUG_INCREMENTAL_EVAL
 
 class Evaluation final {
 public:
     template <EnumColor Color>
-    [[nodiscard]] static inline auto Run(GameState& Board) noexcept {
-        constexpr auto Relative = (Color == White ? 1 : -1);
-        constexpr int PieceScore[6] {100, 300, 300, 500, 900, 10000};
-        auto material_score = 0; int index = 0;
-        auto WhitePieces = Board[White], BlackPieces = Board[Black];
-        for (auto set = &Board[Pawns]; set <= &Board[King]; ++set, ++index) {
-            auto white_set = *set & WhitePieces, black_set = *set & BlackPieces;
-
-            while (white_set) {
-                auto square = Utils::PopLS1B(white_set);
-                material_score += PieceScore[index] + PieceSquareScore<White>[index][square];
-            }
-
-            while (black_set) {
-                auto square = Utils::PopLS1B(black_set);
-                material_score -= PieceScore[index] + PieceSquareScore<Black>[index][square];
-            }
-
-        } return Relative * material_score;
+    [[nodiscard]] static inline int Run(GameState& Board) noexcept {
+        #if defined(DEBUG_INCREMENTAL_EVAL)
+        assert(Board.psqt  == PieceSquare::Accumulate(Board));
+        assert(Board.phase == PieceSquare::GamePhase(Board));
+        assert(Board.pawn_hash == ZobristHashing::PawnHash(Board));
+        if (NNUE::enabled) {
+            auto Fresh = Board; NNUE::Refresh(Fresh);
+            assert(Fresh.nnue.values == Board.nnue.values);
+        }
+        #endif
+
+        if (int score; EvalCache::Probe(Board.hash, score)) return score;
+
+        const auto score = NNUE::enabled ? NNUE::Evaluate<Color>(Board) : Classical<Color>(Board);
+        EvalCache::Store(Board.hash, score);
+        return score;
     };
+
+private:
+    template <EnumColor Color>
+    [[nodiscard]] static inline int Classical(GameState& Board) noexcept {
+        constexpr auto Relative = (Color == White ? 1 : -1);
+
+        const auto& Pawn = PawnHash::Probe(Board);
+        const auto score = Board.psqt + Pawn.score
+                         + Activity<White>(Board, Pawn) - Activity<Black>(Board, Pawn);
+        return Relative * PieceSquare::Taper(score, Board.phase);
+    }
+
+    // Per square reached, centred on a typical count so that an average piece scores 0.
+    static constexpr auto Mobility = [] {
+        constexpr int Weight[4][2] { { 4, 4 }, { 5, 5 }, { 2, 4 }, { 1, 2 } };
+        constexpr int Centre[4]    { 4, 6, 7, 13 };
+        std::array<std::array<Score, 28>, 4> table { };
+        for (auto piece = 0; piece < 4; ++piece)
+            for (auto count = 0; count < 28; ++count)
+                table[piece][count] = S(Weight[piece][0] * (count - Centre[piece]),
+                                        Weight[piece][1] * (count - Centre[piece]));
+        return table;
+    }();
+
+    static constexpr int KingAttackWeight[4] { 2, 2, 3, 5 };
+
+    static constexpr Score ShieldPawn     = S(10,  0);
+    static constexpr Score KnightOutpost  = S(20, 10);
+    static constexpr Score BishopOutpost  = S(10,  5);
+
+    // Mobility, pressure on the enemy king zone, king shelter and outposts of one side, as
+    // a White-relative score once the caller subtracts Black's. Attack sets come from the
+    // usual magic lookups, the popcounts are batched through EvalKernels, pawn attacks and
+    // spans come from the pawn hash.
+    template <EnumColor Color>
+    [[nodiscard]] static inline Score Activity(const GameState& Board, const PawnEntry& Pawn) noexcept {
+        constexpr auto Enemies  = ~Color;
+        constexpr auto Outposts = Color == White ? Rank_4|Rank_5|Rank_6 : Rank_3|Rank_4|Rank_5;
+        const auto occupancy = Board[White] | Board[Black];
+        const auto king      = Utils::IndexLS1B(Board[King] & Board[Enemies]);
+        const auto area      = ~(Board[Color] | Pawn.attacks[Enemies]);
+        const auto zone      = GetAttack<King>::On(king) | king;
+        const auto own_king  = Utils::IndexLS1B(Board[King] & Board[Color]);
+        const auto around    = GetAttack<King>::On(own_king) | own_king;
+        const auto shelter   = (Color == White ? around << 8 : around >> 8)
+                             & ~(Bitboard(Rank_1) << (int(own_king) & 56));
+        const auto outposts  = Outposts & Pawn.attacks[Color] & ~Pawn.spans[Enemies];
+
+        AttackBatch Batch;
+        const auto Push = [&Batch](EnumPiece piece, Bitboard attacks) {
+            Batch.pieces [Batch.size  ] = piece;
+            Batch.attacks[Batch.size++] = attacks;
+        };
+        for (auto set = Board[Knights] & Board[Color]; set; )
+            Push(Knights, GetAttack<Knights>::On(Utils::PopLS1B(set)));
+        for (auto set = Board[Bishops] & Board[Color]; set; )
+            Push(Bishops, GetAttack<Bishops>::On(Utils::PopLS1B(set), occupancy));
+        for (auto set = Board[Rooks  ] & Board[Color]; set; )
+            Push(Rooks,   GetAttack<Rooks  >::On(Utils::PopLS1B(set), occupancy));
+        for (auto set = Board[Queens ] & Board[Color]; set; )
+            Push(Queens,  GetAttack<Queens >::On(Utils::PopLS1B(set), occupancy));
+
+        EvalKernels::Counts mobility, attacks;
+        EvalKernels::Count(Batch, area, zone, mobility, attacks);
+
+        Score score = ShieldPawn    * std::min(3, int(Utils::PopCount(shelter & Board[Pawns] & Board[Color])))
+                    + KnightOutpost * Utils::PopCount(outposts & Board[Knights] & Board[Color])
+                    + BishopOutpost * Utils::PopCount(outposts & Board[Bishops] & Board[Color]);
+        auto units = 0, attackers = 0;
+        for (auto i = 0; i < Batch.size; ++i) {
+            const auto piece = Batch.pieces[i] - Knights;
+            score += Mobility[piece][mobility[i]];
+            if (attacks[i]) ++attackers, units += attacks[i] * KingAttackWeight[piece];
+        }
+
+        // A lone attacker is rarely dangerous, two or more grow roughly quadratically.
+        if (attackers >= 2) {
+            const auto danger = std::min(units * units / 4, 300);
+            score += S(danger, danger / 4);
+        } return score;
+    }
 };
@@ -29,6 +29,7 @@ void FEN::LoadPieces(std::string ranks, GameState& board) {
                 auto piece = (piece_idx) - (color ? 6 : 0) + 2;
                 auto bitboard = Utils::MakeSquare(start_square - (square % 8));
                 board.pieces[piece] |= bitboard, board.pieces[color] |= bitboard;
+                board.mailbox[Utils::IndexLS1B(bitboard)] = EnumPiece(piece);
             } else throw std::runtime_error("FEN: Syntax Error");
             square--;
         } ranks.erase(0, slash+1);
@@ -1,10 +1,16 @@
 #include "ZobristHashing.hpp"
+#include "PieceSquare.hpp"
+#include "NNUE.hpp"
 #include "GameState.hpp"
 #include "FEN.hpp"
 
 GameState::GameState(const std::string& fen) {
     FEN::Load(fen, *this);
     hash = ZobristHashing::Hash(*this);
+    pawn_hash = ZobristHashing::PawnHash(*this);
+    psqt  = PieceSquare::Accumulate(*this);
+    phase = PieceSquare::GamePhase(*this);
+    if (NNUE::enabled) NNUE::Refresh(*this);
 }
 
 #define DEBUG_UNICODE
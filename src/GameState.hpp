@@ -10,11 +10,20 @@
 #include <sstream>
 #include <algorithm>
 
+#define NNUE_HIDDEN 32
+
+// First layer of the NNUE evaluator, one half per perspective (see NNUE.hpp).
+struct alignas(32) Accumulator {
+    std::array<std::array<std::int16_t, NNUE_HIDDEN>, 2> values;
+};
+
 class GameState final {
     friend class  TranspositionTable;
     friend class  ZobristHashing;
     friend class  MoveGeneration;
     friend class  Evaluation;
+    friend class  NNUE;
+    friend class  PawnHash;
     friend class  Search;
     friend class  Perft;
     friend struct Move;
@@ -43,6 +52,19 @@ public:
         else return false;
     }
 
+    // Every piece of ~Color attacking `square`.
+    template <EnumColor Color> [[nodiscard]]
+    static inline Bitboard Attackers(GameState& Board, EnumSquare square) noexcept {
+        const auto enemies   = Board[~Color];
+        const auto occupancy = Board[ Color] | enemies;
+
+        return ((GetAttack<Color, Pawns>::On(square)            & Board[Pawns  ])
+             |  (GetAttack<Knights     >::On(square)            & Board[Knights])
+             |  (GetAttack<Bishops     >::On(square, occupancy) & (Board[Bishops] | Board[Queens]))
+             |  (GetAttack<Rooks       >::On(square, occupancy) & (Board[Rooks  ] | Board[Queens]))
+             |  (GetAttack<King        >::On(square)            & Board[King   ])) & enemies;
+    }
+
     [[nodiscard]] inline Bitboard& operator[](std::uint8_t query) noexcept {
         return pieces[query];
     }
@@ -51,6 +73,10 @@ public:
         return pieces[query];
     }
 
+    [[nodiscard]] constexpr inline auto PieceOn(EnumSquare square) const noexcept {
+        return mailbox[square];
+    }
+
     [[nodiscard]] constexpr inline auto GetEnPassant() const noexcept {
         return en_passant;
     }
@@ -64,7 +90,15 @@ private:
 
     std::array<Bitboard, 8> pieces { };
 
+    // Piece type on each square (EnumPiece(0) when empty), kept in sync with `pieces`.
+    // The colour is one AND away: `Board[Black] & square`.
+    std::array<EnumPiece, 64> mailbox { };
+
     std::uint64_t  hash;
+    std::uint64_t  pawn_hash; // pawns of both colours only, keys the PawnHash table
+    std::int32_t   psqt;  // material + piece-square, packed midgame/endgame, White's side
+    int            phase; // 24 down to 0 as pieces come off, see PieceSquare::PhaseWeight
+    Accumulator    nnue;  // only kept up to date while NNUE::enabled
     EnumColor      to_play;
     EnumSquare     en_passant;
     std::bitset<4> castling_rights;
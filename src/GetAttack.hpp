@@ -8,6 +8,51 @@
 #include <iostream>
 #include <sys/types.h>
 
+// PEXT indexes the slider tables without a multiplication. It needs BMI2, and is only worth
+// it where PEXT is not microcoded (AMD before Zen 3 takes hundreds of cycles). Compiled in
+// on x86 unless NO_PEXT is defined, picked at startup from CPUID.
+#if (defined(__x86_64__) || defined(__i386__)) && !defined(NO_PEXT) && !defined(CONSTEXPR_MAGIC_BITBOARD)
+#include <immintrin.h>
+#include <cpuid.h>
+#define SLIDERS_PEXT
+#endif
+
+///////////////////////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////// SLIDER BACKEND ////////////////////////////////////////
+///////////////////////////////////////////////////////////////////////////////////////////////
+
+struct SliderBackend final {
+public:
+    [[nodiscard]] static inline const char* Name() noexcept { return pext ? "pext" : "magic"; }
+
+    // Whether PEXT is there and fast: BMI2, and not an AMD (or Hygon) family before 0x19.
+    [[nodiscard]] static inline bool FastPext() noexcept {
+        #if defined(SLIDERS_PEXT)
+        __builtin_cpu_init();
+        if (!__builtin_cpu_supports("bmi2")) return false;
+        unsigned eax, ebx, ecx, edx;
+        if (!__get_cpuid(0, &eax, &ebx, &ecx, &edx)) return false;
+        const auto amd   = ebx == 0x68747541 && edx == 0x69746e65 && ecx == 0x444d4163; // AuthenticAMD
+        const auto hygon = ebx == 0x6f677948 && edx == 0x6e65476e && ecx == 0x656e6975; // HygonGenuine
+        if (!(amd || hygon) || !__get_cpuid(1, &eax, &ebx, &ecx, &edx)) return true;
+        const auto family = ((eax >> 8) & 0xf) + (((eax >> 8) & 0xf) == 0xf ? (eax >> 20) & 0xff : 0);
+        return family >= 0x19;
+        #else
+        return false;
+        #endif
+    }
+
+    static inline const bool pext = FastPext();
+
+private:
+     SliderBackend() = delete;
+    ~SliderBackend() = delete;
+};
+
+#if !defined(FIXED_SHIFT_MAGICS)
+inline std::array<Bitboard, FANCY_BISHOP_ENTRIES + FANCY_ROOK_ENTRIES> FancyTable { };
+#endif
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 ////////////////////////////////////// ATTACK DISPATCHER //////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -56,22 +101,42 @@ template <>
 struct GetAttack<Bishops> final {
 public:
     [[nodiscard]] static _constexpr auto On(EnumSquare square, Bitboard occupancy) noexcept {
+        #if defined(SLIDERS_PEXT)
+        if (SliderBackend::pext) return Pext(square, occupancy);
+        #endif
+        return Magic(square, occupancy);
+    }
+
+    [[nodiscard]] static _constexpr Bitboard Magic(EnumSquare square, Bitboard occupancy) noexcept {
+        #if defined(FIXED_SHIFT_MAGICS)
         // STRUCT OF ARRAY
         occupancy &= Magics.Masks[square];
         occupancy *= Magics.Numbers[square];
         occupancy >>= (64-9);
         return Magics.Attacks[square][occupancy];
+        #else
+        const auto& Entry = Magics[square];
+        return Entry.Attacks[((occupancy & Entry.Mask) * Entry.Number) >> Entry.Shift];
+        #endif
+    }
 
-        // ARRAY OF STRUCT
-        // occupancy &= Magics[square].Mask;
-        // occupancy *= Magics[square].Number;
-        // occupancy >>= (64-9);
-        // return Magics[square].Attack[occupancy];
+    #if defined(SLIDERS_PEXT)
+    __attribute__((target("bmi2")))
+    [[nodiscard]] static inline Bitboard Pext(EnumSquare square, Bitboard occupancy) noexcept {
+        return PextTable.Attacks[PextTable.Offsets[square] + _pext_u64(occupancy, PextTable.Masks[square])];
     }
+    #endif
 
 private:
+    #if defined(FIXED_SHIFT_MAGICS)
     const static _constexpr auto Magics = Generator::Attacks<Bishops>::Magics_SOA();
-    // const static _constexpr auto Magics = Generator::Attacks<Bishops>::Magics_AOS();
+    #else
+    const static inline auto Magics = Generator::Attacks<Bishops>::FancyMagics(&FancyTable[0]);
+    #endif
+
+    #if defined(SLIDERS_PEXT)
+    const static inline auto PextTable = Generator::Attacks<Bishops>::Pext_SOA();
+    #endif
 
      GetAttack() = delete;
     ~GetAttack() = delete;
@@ -83,23 +148,42 @@ template <>
 struct GetAttack<Rooks> final {
 public:
     [[nodiscard]] static _constexpr auto On(EnumSquare square, Bitboard occupancy) noexcept {
+        #if defined(SLIDERS_PEXT)
+        if (SliderBackend::pext) return Pext(square, occupancy);
+        #endif
+        return Magic(square, occupancy);
+    }
+
+    [[nodiscard]] static _constexpr Bitboard Magic(EnumSquare square, Bitboard occupancy) noexcept {
+        #if defined(FIXED_SHIFT_MAGICS)
         // STRUCT OF ARRAY
         occupancy &= Magics.Masks[square];
         occupancy *= Magics.Numbers[square];
         occupancy >>= (64-12);
         return Magics.Attacks[square][occupancy];
+        #else
+        const auto& Entry = Magics[square];
+        return Entry.Attacks[((occupancy & Entry.Mask) * Entry.Number) >> Entry.Shift];
+        #endif
+    }
 
-        // ARRAY OF STRUCT
-        // occupancy &= Magics[square].Mask;
-        // occupancy *= Magics[square].Number;
-        // occupancy >>= (64-12);
-        // return Magics[square].Attack[occupancy];
-
-       }
+    #if defined(SLIDERS_PEXT)
+    __attribute__((target("bmi2")))
+    [[nodiscard]] static inline Bitboard Pext(EnumSquare square, Bitboard occupancy) noexcept {
+        return PextTable.Attacks[PextTable.Offsets[square] + _pext_u64(occupancy, PextTable.Masks[square])];
+    }
+    #endif
 
 private:
+    #if defined(FIXED_SHIFT_MAGICS)
     const static _constexpr auto Magics = Generator::Attacks<Rooks>::Magics_SOA();
-    // const static _constexpr auto Magics = Generator::Attacks<Rooks>::Magics_AOS();
+    #else
+    const static inline auto Magics = Generator::Attacks<Rooks>::FancyMagics(&FancyTable[FANCY_BISHOP_ENTRIES]);
+    #endif
+
+    #if defined(SLIDERS_PEXT)
+    const static inline auto PextTable = Generator::Attacks<Rooks>::Pext_SOA();
+    #endif
 
      GetAttack() = delete;
     ~GetAttack() = delete;
@@ -120,6 +204,26 @@ private:
     ~GetAttack() = delete;
 };
 
+/////////////////////////////////////////// RAYS //////////////////////////////////////////////
+
+struct GetRay final {
+public:
+    [[nodiscard]] static constexpr auto Between(EnumSquare from, EnumSquare to) noexcept {
+        return BetweenTable[from][to];
+    }
+
+    [[nodiscard]] static constexpr auto Line(EnumSquare from, EnumSquare to) noexcept {
+        return LineTable[from][to];
+    }
+
+private:
+    static constexpr auto BetweenTable = Generator::Rays::Between();
+    static constexpr auto LineTable    = Generator::Rays::Line();
+
+     GetRay() = delete;
+    ~GetRay() = delete;
+};
+
 ///////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////////////////////
@@ -1,6 +1,8 @@
 #pragma once
 
 #include "ZobristHashing.hpp"
+#include "PieceSquare.hpp"
+#include "NNUE.hpp"
 #include "ChessEngine.hpp"
 #include "GameState.hpp"
 #include "GetAttack.hpp"
@@ -10,15 +12,21 @@
 #include <iomanip>
 
 #define USE_HASH_TABLE
+#define USE_MAKE_UNMAKE
 
 #if defined(USE_HASH_TABLE)
 
 #define HASH_UPDATE_MOVE                                                          \
     Board.hash ^= ZobristHashing::Keys.Piece[piece+(Allies*6)-2][origin];         \
-    Board.hash ^= ZobristHashing::Keys.Piece[piece+(Allies*6)-2][target];
+    Board.hash ^= ZobristHashing::Keys.Piece[piece+(Allies*6)-2][target];         \
+    if (piece == Pawns) Board.pawn_hash ^=                                        \
+        ZobristHashing::Keys.Piece[Pawns+(Allies*6)-2][origin] ^                  \
+        ZobristHashing::Keys.Piece[Pawns+(Allies*6)-2][target];
 
 #define HASH_UPDATE_CAPTURE                                                       \
-    Board.hash ^= ZobristHashing::Keys.Piece[piece+(Enemies*6)-2][target];
+    Board.hash ^= ZobristHashing::Keys.Piece[piece+(Enemies*6)-2][target];        \
+    if (piece == Pawns)                                                           \
+        Board.pawn_hash ^= ZobristHashing::Keys.Piece[Pawns+(Enemies*6)-2][target];
 
 #define HASH_UPDATE_CASTLING_RIGHTS                                               \
     Board.hash ^= ZobristHashing::Keys.Castle[Board.castling_rights.to_ulong()];
@@ -37,11 +45,13 @@
     Board.hash ^= ZobristHashing::Keys.EnPassant[Board.en_passant];
 
 #define HASH_UPDATE_CAPTURE_EN_PASSANT                                            \
-    Board.hash ^= ZobristHashing::Keys.Piece[Pawns+(Enemies*6)-2][target+Down];
+    Board.hash      ^= ZobristHashing::Keys.Piece[Pawns+(Enemies*6)-2][target+Down]; \
+    Board.pawn_hash ^= ZobristHashing::Keys.Piece[Pawns+(Enemies*6)-2][target+Down];
 
 #define HASH_UPDATE_PROMOTION                                                     \
     Board.hash ^= ZobristHashing::Keys.Piece[Pawns+(Allies*6)-2][origin];         \
-    Board.hash ^= ZobristHashing::Keys.Piece[promotion+(Allies*6)-2][target];
+    Board.hash ^= ZobristHashing::Keys.Piece[promotion+(Allies*6)-2][target];     \
+    Board.pawn_hash ^= ZobristHashing::Keys.Piece[Pawns+(Allies*6)-2][origin];
 
 #define HASH_UPDATE_SIDE                                                         \
     Board.hash ^= ZobristHashing::Keys.Side;
@@ -60,6 +70,30 @@
 
 #endif
 
+#define EVAL_UPDATE_MOVE                                                          \
+    Board.psqt += PieceSquare::Get(Allies, piece, target)                         \
+               -  PieceSquare::Get(Allies, piece, origin);
+
+#define EVAL_UPDATE_CAPTURE                                                       \
+    Board.psqt  -= PieceSquare::Get(Enemies, piece, target);                      \
+    Board.phase -= PieceSquare::Phase(piece);
+
+#define EVAL_UPDATE_CASTLING_KING_ROOK                                            \
+    Board.psqt += PieceSquare::Get(Allies, Rooks, KingRookTo)                     \
+               -  PieceSquare::Get(Allies, Rooks, KingRook);
+
+#define EVAL_UPDATE_CASTLING_QUEEN_ROOK                                           \
+    Board.psqt += PieceSquare::Get(Allies, Rooks, QueenRookTo)                    \
+               -  PieceSquare::Get(Allies, Rooks, QueenRook);
+
+#define EVAL_UPDATE_CAPTURE_EN_PASSANT                                            \
+    Board.psqt -= PieceSquare::Get(Enemies, Pawns, target+Down);
+
+#define EVAL_UPDATE_PROMOTION                                                     \
+    Board.psqt  += PieceSquare::Get(Allies, promotion, target)                    \
+                -  PieceSquare::Get(Allies, Pawns, origin);                       \
+    Board.phase += PieceSquare::Phase(promotion);
+
 enum EnumMoveFlags: std::uint8_t {
     Quiet            = 0b0000,
     DoublePush       = 0b0001,
@@ -104,6 +138,34 @@ constexpr inline EnumMoveFlags operator|(EnumMoveFlags lhs, EnumMoveFlags rhs) n
     return lhs+rhs;
 }
 
+#define NNUE_UPDATE                                                               \
+    if (NNUE::enabled) Move::UpdateAccumulator<Allies>(Board, move, Undo.captured);
+
+// Everything Move::Make cannot recompute when taking a move back, one record per ply.
+struct UndoState final {
+    std::uint64_t  hash;
+    std::uint64_t  pawn_hash;
+    std::int32_t   psqt;
+    int            phase;
+    std::bitset<4> castling_rights;
+    EnumSquare     en_passant;
+    EnumPiece      captured;
+    int            half_moves;
+    Accumulator    nnue; // saved only while NNUE::enabled
+};
+
+#if defined(USE_MAKE_UNMAKE)
+
+#define STATE_SAVE(Board)
+#define STATE_RESTORE(Color, Board, move, Undo) Move::Unmake<Color>(Board, move, Undo)
+
+#else
+
+#define STATE_SAVE(Board)                       const GameState Old = Board
+#define STATE_RESTORE(Color, Board, move, Undo) Board = Old
+
+#endif
+
 struct Move final {
     EnumPiece     piece;
     EnumSquare    origin;
@@ -121,26 +183,48 @@ struct Move final {
         };
     }
 
-    template<EnumColor Color> [[nodiscard]]
-    static inline auto Make(GameState& Board, const Move& move) noexcept {
-        constexpr auto Allies    = Color, Enemies = ~Color;
-        constexpr auto Down      = Allies == White ? South : North;
-        constexpr auto KingRook  = Allies == White ? h1 : h8;
-        constexpr auto QueenRook = Allies == White ? a1 : a8;
-        constexpr auto Kk        = Allies == White ? 0 : 2;
-        constexpr auto Qq        = Allies == White ? 1 : 3;
+    [[nodiscard]] static inline constexpr auto Promotion(EnumMoveFlags flags) noexcept {
+        return EnumPiece(Knights + (flags & 0b0011));
+    }
+
+    // Plays `move` and tells whether it was legal. Moves that come from the legal generator
+    // are known to be, `Verify=false` skips the InCheck test for them.
+    template<EnumColor Color, bool Verify=true> [[nodiscard]]
+    static inline auto Make(GameState& Board, const Move& move, UndoState& Undo) noexcept {
+        constexpr auto Allies      = Color, Enemies = ~Color;
+        constexpr auto Down        = Allies == White ? South : North;
+        constexpr auto KingRook    = Allies == White ? h1 : h8;
+        constexpr auto QueenRook   = Allies == White ? a1 : a8;
+        constexpr auto KingRookTo  = Allies == White ? f1 : f8;
+        constexpr auto QueenRookTo = Allies == White ? d1 : d8;
+        constexpr auto Kk          = Allies == White ? 0 : 2;
+        constexpr auto Qq          = Allies == White ? 1 : 3;
 
         const auto [piece, origin, target, flags] = move;
 
+        Undo.hash            = Board.hash;
+        Undo.pawn_hash       = Board.pawn_hash;
+        Undo.psqt            = Board.psqt;
+        Undo.phase           = Board.phase;
+        Undo.castling_rights = Board.castling_rights;
+        Undo.en_passant      = Board.en_passant;
+        Undo.captured        = EnumPiece(0);
+        Undo.half_moves      = Board.half_moves;
+        if (NNUE::enabled) Undo.nnue = Board.nnue;
+
+        if (piece == Pawns || (flags & Capture)) Board.half_moves = 0;
+        else ++Board.half_moves;
+
         if (Board.en_passant) HASH_UPDATE_EN_PASSANT;
 
         //////////////////////////////////////// QUIET ///////////////////////////////////////
 
-        if (flags == Quiet) { HASH_UPDATE_SIDE; HASH_UPDATE_MOVE;
+        if (flags == Quiet) { HASH_UPDATE_SIDE; HASH_UPDATE_MOVE; EVAL_UPDATE_MOVE;
 
             Board.to_play = Enemies;
             Board.en_passant = EnumSquare(0);
             Board[Allies] ^= (Board[piece] ^= (origin|target), (origin|target));
+            Board.mailbox[origin] = EnumPiece(0), Board.mailbox[target] = piece;
 
             if (piece == Rooks) {
                 HASH_UPDATE_CASTLING_RIGHTS;
@@ -154,7 +238,8 @@ struct Move final {
                 HASH_UPDATE_CASTLING_RIGHTS;
             }
 
-            return not GameState::InCheck<Allies>(Board, Utils::IndexLS1B(
+            NNUE_UPDATE;
+            return not Verify || not GameState::InCheck<Allies>(Board, Utils::IndexLS1B(
                 Board[King] & Board[Allies])
             );
 
@@ -164,28 +249,26 @@ struct Move final {
          ////////////////////////////////////// CAPTURE //////////////////////////////////////
 
             if (flags & Capture) {
-                for (int piece = Pawns; piece <= King; ++piece) {
-
-                    if (Board[piece] & target) {
-                        Board[Enemies] ^= (Board[piece] ^= target, target);
-                        HASH_UPDATE_CAPTURE;
-                        if (piece == Rooks) {
-                            constexpr auto EnemyKingRook  = Allies == White ? h8 : h1;
-                            constexpr auto EnemyQueenRook = Allies == White ? a8 : a1;
-                            constexpr auto EnemyKk        = Allies == White ? 2  : 0 ;
-                            constexpr auto EnemyQq        = Allies == White ? 3  : 1 ;
-
-                            if (target == EnemyKingRook) {
-                                HASH_UPDATE_CASTLING_RIGHTS;
-                                Board.castling_rights[EnemyKk] = 0;
-                                HASH_UPDATE_CASTLING_RIGHTS;
-                            }
-
-                            else if (target == EnemyQueenRook) {
-                                HASH_UPDATE_CASTLING_RIGHTS;
-                                Board.castling_rights[EnemyQq] = 0;
-                                HASH_UPDATE_CASTLING_RIGHTS;
-                            }
+                if (const auto piece = Board.mailbox[target]) {
+                    Board[Enemies] ^= (Board[piece] ^= target, target);
+                    Undo.captured = piece;
+                    HASH_UPDATE_CAPTURE; EVAL_UPDATE_CAPTURE;
+                    if (piece == Rooks) {
+                        constexpr auto EnemyKingRook  = Allies == White ? h8 : h1;
+                        constexpr auto EnemyQueenRook = Allies == White ? a8 : a1;
+                        constexpr auto EnemyKk        = Allies == White ? 2  : 0 ;
+                        constexpr auto EnemyQq        = Allies == White ? 3  : 1 ;
+
+                        if (target == EnemyKingRook) {
+                            HASH_UPDATE_CASTLING_RIGHTS;
+                            Board.castling_rights[EnemyKk] = 0;
+                            HASH_UPDATE_CASTLING_RIGHTS;
+                        }
+
+                        else if (target == EnemyQueenRook) {
+                            HASH_UPDATE_CASTLING_RIGHTS;
+                            Board.castling_rights[EnemyQq] = 0;
+                            HASH_UPDATE_CASTLING_RIGHTS;
                         }
                     }
                 }
@@ -199,31 +282,36 @@ struct Move final {
             }
 
             else if (flags == CastleKing)  { HASH_UPDATE_CASTLING_KING_ROOK;
+                EVAL_UPDATE_CASTLING_KING_ROOK;
                 constexpr auto CastleK = Allies == White ? (h1|f1) : (h8|f8);
                 Board[Allies] ^= (Board[Rooks] ^= CastleK, CastleK);
+                Board.mailbox[KingRook] = EnumPiece(0), Board.mailbox[KingRookTo] = Rooks;
             }
 
             else if (flags == CastleQueen) { HASH_UPDATE_CASTLING_QUEEN_ROOK;
+                EVAL_UPDATE_CASTLING_QUEEN_ROOK;
                 constexpr auto CastleQ = Allies == White ? (a1|d1) : (a8|d8);
                 Board[Allies] ^= (Board[Rooks] ^= CastleQ, CastleQ);
+                Board.mailbox[QueenRook] = EnumPiece(0), Board.mailbox[QueenRookTo] = Rooks;
             }
 
             if (flags == EnPassant)        { HASH_UPDATE_CAPTURE_EN_PASSANT;
+                EVAL_UPDATE_CAPTURE_EN_PASSANT;
                 Board[Enemies] ^= (Board[Pawns] ^= target+Down, target+Down);
+                Board.mailbox[target+Down] = EnumPiece(0);
             }
 
             else if (flags & PromotionKnight) {
-                const auto promotion =
-                flags == PromotionBishop || flags == XPromotionBishop ? Bishops :
-                flags == PromotionRook   || flags == XPromotionRook   ? Rooks   :
-                flags == PromotionQueen  || flags == XPromotionQueen  ? Queens  : Knights;
+                const auto promotion = Move::Promotion(flags);
 
-                HASH_UPDATE_SIDE; HASH_UPDATE_PROMOTION;
+                HASH_UPDATE_SIDE; HASH_UPDATE_PROMOTION; EVAL_UPDATE_PROMOTION;
 
                 Board[Allies] ^= (Board[Pawns] ^= origin, (origin|target));
                 Board[promotion] |= target; Board.to_play = Enemies;
+                Board.mailbox[origin] = EnumPiece(0), Board.mailbox[target] = promotion;
 
-                return not GameState::InCheck<Allies>(Board, Utils::IndexLS1B(
+                NNUE_UPDATE;
+                return not Verify || not GameState::InCheck<Allies>(Board, Utils::IndexLS1B(
                     Board[King] & Board[Allies])
                 );
             }
@@ -242,17 +330,111 @@ struct Move final {
 
         //////////////////////////////////////////////////////////////////////////////////////
 
-            HASH_UPDATE_SIDE; HASH_UPDATE_MOVE;
+            HASH_UPDATE_SIDE; HASH_UPDATE_MOVE; EVAL_UPDATE_MOVE;
 
             Board.to_play  = Enemies;
             Board[Allies] ^= (Board[piece] ^= (origin|target), (origin|target));
+            Board.mailbox[origin] = EnumPiece(0), Board.mailbox[target] = piece;
 
-            return not GameState::InCheck<Allies>(Board, Utils::IndexLS1B(
+            NNUE_UPDATE;
+            return not Verify || not GameState::InCheck<Allies>(Board, Utils::IndexLS1B(
                 Board[King] & Board[Allies])
             );
         }
     }
 
+    // Takes back `move` played by `Color`, the irreversible state comes from `Undo`.
+    template<EnumColor Color>
+    static inline auto Unmake(GameState& Board, const Move& move, const UndoState& Undo) noexcept {
+        constexpr auto Allies    = Color, Enemies = ~Color;
+        constexpr auto Down      = Allies == White ? South : North;
+        constexpr auto KingRook  = Allies == White ? h1 : h8;
+        constexpr auto QueenRook = Allies == White ? a1 : a8;
+
+        const auto [piece, origin, target, flags] = move;
+
+        if (flags & PromotionKnight) {
+            Board[Move::Promotion(flags)] ^= target;
+            Board[Allies] ^= (Board[Pawns] ^= origin, (origin|target));
+            Board.mailbox[origin] = Pawns;
+        } else {
+            Board[Allies] ^= (Board[piece] ^= (origin|target), (origin|target));
+            Board.mailbox[origin] = piece;
+        } Board.mailbox[target] = Undo.captured;
+
+        if (flags == EnPassant) {
+            Board[Enemies] ^= (Board[Pawns] ^= target+Down, target+Down);
+            Board.mailbox[target+Down] = Pawns;
+        }
+
+        else if (Undo.captured)
+            Board[Enemies] ^= (Board[Undo.captured] ^= target, target);
+
+        else if (flags == CastleKing) {
+            constexpr auto CastleK = Allies == White ? (h1|f1) : (h8|f8);
+            Board[Allies] ^= (Board[Rooks] ^= CastleK, CastleK);
+            Board.mailbox[KingRook] = Rooks, Board.mailbox[KingRook-2] = EnumPiece(0);
+        }
+
+        else if (flags == CastleQueen) {
+            constexpr auto CastleQ = Allies == White ? (a1|d1) : (a8|d8);
+            Board[Allies] ^= (Board[Rooks] ^= CastleQ, CastleQ);
+            Board.mailbox[QueenRook] = Rooks, Board.mailbox[QueenRook+3] = EnumPiece(0);
+        }
+
+        Board.to_play         = Allies;
+        Board.hash            = Undo.hash;
+        Board.pawn_hash       = Undo.pawn_hash;
+        Board.psqt            = Undo.psqt;
+        Board.phase           = Undo.phase;
+        Board.castling_rights = Undo.castling_rights;
+        Board.en_passant      = Undo.en_passant;
+        Board.half_moves      = Undo.half_moves;
+        if (NNUE::enabled) Board.nnue = Undo.nnue;
+    }
+
+    // Brings the NNUE accumulator up to date once the board itself has been updated. The
+    // perspective whose king moved is recomputed, every other change is a few add/sub.
+    template<EnumColor Color>
+    static inline void UpdateAccumulator(GameState& Board, const Move& move, EnumPiece captured) noexcept {
+        UpdateAccumulator<White, Color>(Board, move, captured);
+        UpdateAccumulator<Black, Color>(Board, move, captured);
+    }
+
+    template<EnumColor Perspective, EnumColor Color>
+    static inline void UpdateAccumulator(GameState& Board, const Move& move, EnumPiece captured) noexcept {
+        constexpr auto Enemies = ~Color;
+        constexpr auto Down    = Color == White ? South : North;
+        const auto [piece, origin, target, flags] = move;
+        if (piece == King && Color == Perspective) return NNUE::Refresh<Perspective>(Board);
+
+        auto& accumulator = Board.nnue.values[Perspective];
+        const auto king   = Utils::IndexLS1B(Board[King] & Board[Perspective]);
+
+        NNUE::Sub(accumulator, NNUE::Feature<Perspective>(king, Color, piece, origin));
+        NNUE::Add(accumulator, NNUE::Feature<Perspective>(king, Color, Board.PieceOn(target), target));
+
+        if (flags == EnPassant)
+            NNUE::Sub(accumulator, NNUE::Feature<Perspective>(king, Enemies, Pawns, target+Down));
+        else if (captured)
+            NNUE::Sub(accumulator, NNUE::Feature<Perspective>(king, Enemies, captured, target));
+        else if (flags == CastleKing || flags == CastleQueen) {
+            const auto from = EnumSquare(flags == CastleKing ? origin+3 : origin-4);
+            const auto to   = EnumSquare(flags == CastleKing ? origin+1 : origin-1);
+            NNUE::Sub(accumulator, NNUE::Feature<Perspective>(king, Color, Rooks, from));
+            NNUE::Add(accumulator, NNUE::Feature<Perspective>(king, Color, Rooks, to));
+        }
+    }
+
+    [[nodiscard]] constexpr inline bool operator==(const Move& other) const noexcept {
+        return piece  == other.piece  && origin == other.origin
+            && target == other.target && flags  == other.flags;
+    }
+
+    [[nodiscard]] constexpr inline bool operator!=(const Move& other) const noexcept {
+        return !(*this == other);
+    }
+
     friend inline std::ostream& operator<<(std::ostream& os, const Move& move) {
         return os << move.origin << move.target
                   << ((move.flags  &  PromotionKnight) ?
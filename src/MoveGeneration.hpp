@@ -5,11 +5,27 @@
 #include "GetAttack.hpp"
 #include "Utils.hpp"
 #include "Move.hpp"
+#include "NodeAttacks.hpp"
 
 #include <iomanip>
+#include <tuple>
 
 using MoveList = std::array<Move, 218>;
 
+// Which part of the pseudo-legal moves to generate. GenCaptures holds every capture
+// (en passant included) and every promotion, GenQuiets holds the rest. GenEvasions is
+// only valid in check: king moves, plus captures of and interpositions to a lone checker.
+// GenLegal holds every strictly legal move: checkers and pins are resolved up front, so
+// the moves can be played with Move::Make<Color, false> which skips its InCheck test.
+// Checkers, pins and enemy attacks come from a NodeAttacks, the search passes its own.
+enum EnumGenType: std::uint8_t {
+    GenCaptures,
+    GenQuiets,
+    GenEvasions,
+    GenAll,
+    GenLegal
+};
+
 class MoveGeneration final {
 public:
     template <EnumColor Color>
@@ -18,95 +34,286 @@ public:
         MoveList moves;
 
         auto iterator = moves.begin();
-        PseudoLegal<Color, Pawns  >(Board, iterator);
-        PseudoLegal<Color, Knights>(Board, iterator);
-        PseudoLegal<Color, Bishops>(Board, iterator);
-        PseudoLegal<Color, Rooks  >(Board, iterator);
-        PseudoLegal<Color, Queens >(Board, iterator);
-        PseudoLegal<Color, King   >(Board, iterator);
+        Generate<Color, GenAll>(Board, iterator);
 
         const auto nmoves = std::distance(moves.begin(), iterator);
         return { moves, nmoves };
     }
 
-private:
+    template <EnumColor Color>
+    static inline auto Captures(GameState& Board) noexcept -> std::tuple<MoveList, int> {
+        MoveList moves; auto iterator = moves.begin();
+        Generate<Color, GenCaptures>(Board, iterator);
+        return { moves, std::distance(moves.begin(), iterator) };
+    }
+
+    template <EnumColor Color>
+    static inline auto Quiets(GameState& Board) noexcept -> std::tuple<MoveList, int> {
+        MoveList moves; auto iterator = moves.begin();
+        Generate<Color, GenQuiets>(Board, iterator);
+        return { moves, std::distance(moves.begin(), iterator) };
+    }
+
+    template <EnumColor Color>
+    static inline auto Evasions(GameState& Board) noexcept -> std::tuple<MoveList, int> {
+        MoveList moves; auto iterator = moves.begin();
+        Generate<Color, GenEvasions>(Board, iterator);
+        return { moves, std::distance(moves.begin(), iterator) };
+    }
+
+    template <EnumColor Color>
+    static inline auto Legal(GameState& Board) noexcept -> std::tuple<MoveList, int> {
+        MoveList moves; auto iterator = moves.begin();
+        Generate<Color, GenLegal>(Board, iterator);
+        return { moves, std::distance(moves.begin(), iterator) };
+    }
+
+    template <EnumColor Color, EnumGenType Type>
+    static inline auto Generate(GameState& Board, MoveList::iterator& Moves) noexcept {
+        NodeAttacks<Color> Node(Board);
+        Generate<Color, Type>(Board, Moves, Node);
+    }
+
+    // Same, with the checkers, pins and threats of a node that may already know them.
+    template <EnumColor Color, EnumGenType Type>
+    static inline auto Generate(GameState& Board, MoveList::iterator& Moves, NodeAttacks<Color>& Node) noexcept {
+        if constexpr(Type == GenLegal) {
+            const auto king     = Node.KingSquare();
+            const auto checkers = Node.Checkers();
+            const auto pinned   = Node.Pinned();
+            PseudoLegal<Color, King, Type>(Board, Moves, Node, ~Node.Threats());
+            if (Utils::PopCount(checkers) > 1) return;
+
+            const auto mask = checkers ?
+                checkers | GetRay::Between(king, Utils::IndexLS1B(checkers)) : ~0ULL;
+            PseudoLegal<Color, Pawns  , Type>(Board, Moves, Node, mask, pinned);
+            PseudoLegal<Color, Knights, Type>(Board, Moves, Node, mask, pinned);
+            PseudoLegal<Color, Bishops, Type>(Board, Moves, Node, mask, pinned);
+            PseudoLegal<Color, Rooks  , Type>(Board, Moves, Node, mask, pinned);
+            PseudoLegal<Color, Queens , Type>(Board, Moves, Node, mask, pinned);
+            return;
+        }
 
-    template <EnumColor Color, EnumPiece Piece> static inline
-    auto PseudoLegal(GameState& Board, MoveList::iterator& Moves) noexcept {
+        if constexpr(Type == GenEvasions) {
+            const auto king     = Node.KingSquare();
+            const auto checkers = Node.Checkers();
+            PseudoLegal<Color, King, Type>(Board, Moves, Node);
+            if (Utils::PopCount(checkers) > 1) return;
+
+            const auto mask = checkers | GetRay::Between(king, Utils::IndexLS1B(checkers));
+            PseudoLegal<Color, Pawns  , Type>(Board, Moves, Node, mask);
+            PseudoLegal<Color, Knights, Type>(Board, Moves, Node, mask);
+            PseudoLegal<Color, Bishops, Type>(Board, Moves, Node, mask);
+            PseudoLegal<Color, Rooks  , Type>(Board, Moves, Node, mask);
+            PseudoLegal<Color, Queens , Type>(Board, Moves, Node, mask);
+            return;
+        }
+
+        PseudoLegal<Color, Pawns  , Type>(Board, Moves, Node);
+        PseudoLegal<Color, Knights, Type>(Board, Moves, Node);
+        PseudoLegal<Color, Bishops, Type>(Board, Moves, Node);
+        PseudoLegal<Color, Rooks  , Type>(Board, Moves, Node);
+        PseudoLegal<Color, Queens , Type>(Board, Moves, Node);
+        PseudoLegal<Color, King   , Type>(Board, Moves, Node);
+    }
+
+    // Whether a move that was not generated for this position (hash move, killer) could
+    // have been: it must be one the pseudo-legal generator would emit here.
+    template <EnumColor Color> [[nodiscard]]
+    static inline bool IsPseudoLegal(GameState& Board, const Move& move) noexcept {
+        NodeAttacks<Color> Node(Board);
+        return IsPseudoLegal<Color>(Board, move, Node);
+    }
+
+    template <EnumColor Color> [[nodiscard]]
+    static inline bool IsPseudoLegal(GameState& Board, const Move& move, NodeAttacks<Color>& Node) noexcept {
         constexpr auto Allies = Color, Enemies = ~Allies;
-        auto set       = (Board[Allies] & Board[Piece  ]);
-        auto occupancy = (Board[Allies] | Board[Enemies]);
+        const auto [piece, origin, target, flags] = move;
+        const auto occupancy = Board[Allies] | Board[Enemies];
 
-        while (set) {
-        EnumSquare origin = Utils::PopLS1B(set);
+        if (!piece || Board.PieceOn(origin) != piece || !(Board[Allies] & origin))
+            return false;
+        if (Board[Allies] & target)
+            return false;
 
-        /////////////////////////////////////// PAWNS ////////////////////////////////////////
+        if (flags == EnPassant)
+            return piece == Pawns && Board.en_passant && target == Board.en_passant
+                && (GetAttack<Allies, Pawns>::On(origin) & target);
 
-        if constexpr(Piece == Pawns) {
+        if (bool(flags & Capture) != bool(Board[Enemies] & target) || (Board[King] & target))
+            return false;
+
+        if (piece == Pawns) {
             constexpr auto StartingRank  = (Allies == White ? Rank_2 : Rank_7);
             constexpr auto PromotionRank = (Allies == White ? Rank_8 : Rank_1);
             constexpr auto Up            = (Allies == White ? North  : South );
 
-            auto attacks = GetAttack<Allies, Piece>::On(origin) & Board[Enemies];
-            while (attacks) {
-                auto attack = Utils::PopLS1B(attacks);
-                *Moves++ = Move::Encode<Piece>(origin, attack, Capture);
-                if (attack & PromotionRank) { --Moves;
-                    *Moves++ = Move::Encode<Piece>(origin, attack, PromotionKnight | Capture);
-                    *Moves++ = Move::Encode<Piece>(origin, attack, PromotionBishop | Capture);
-                    *Moves++ = Move::Encode<Piece>(origin, attack, PromotionRook   | Capture);
-                    *Moves++ = Move::Encode<Piece>(origin, attack, PromotionQueen  | Capture);
-                }
-            }
+            if (bool(flags & PromotionKnight) != bool(target & PromotionRank))
+                return false;
+            if (flags & Capture)
+                return GetAttack<Allies, Pawns>::On(origin) & target;
+            if (flags == DoublePush)
+                return (origin & StartingRank) && target == origin+Up+Up
+                    && !((origin+Up) & occupancy);
+            return (flags == Quiet || (flags & PromotionKnight)) && target == origin+Up;
+        }
+
+        if (flags != Quiet && flags != Capture) {
+            if (piece != King || (flags != CastleKing && flags != CastleQueen)) return false;
+            constexpr auto king = (Allies == White ? e1 : e8);
+            constexpr auto Kk   = (Allies == White ? 0  : 2 );
+            constexpr auto Qq   = (Allies == White ? 1  : 3 );
+            if (flags == CastleKing)
+                return origin == king && target == king+2 && Board.castling_rights[Kk]
+                    && !(((king+1) | (king+2)) & occupancy)
+                    && Node.CanCastleThrough((king+1) | (king+2));
+            else
+                return origin == king && target == king-2 && Board.castling_rights[Qq]
+                    && !(((king-1) | (king-2) | (king-3)) & occupancy)
+                    && Node.CanCastleThrough((king-1) | (king-2));
+        }
+
+        switch (piece) {
+        case Knights: return GetAttack<Knights>::On(origin)            & target;
+        case Bishops: return GetAttack<Bishops>::On(origin, occupancy) & target;
+        case Rooks  : return GetAttack<Rooks  >::On(origin, occupancy) & target;
+        case Queens : return GetAttack<Queens >::On(origin, occupancy) & target;
+        case King   : return GetAttack<King   >::On(origin)            & target;
+        default     : return false;
+        }
+    }
+
+private:
+
+    // Capturing en passant empties two squares of the same rank at once, which can expose
+    // the king to a slider even when neither pawn is pinned on its own.
+    template <EnumColor Color> [[nodiscard]]
+    static inline bool EnPassantDiscovers(GameState& Board, EnumSquare origin) noexcept {
+        constexpr auto Allies = Color, Enemies = ~Allies;
+        constexpr auto Down   = (Allies == White ? South : North);
+        const auto king      = Utils::IndexLS1B(Board[King] & Board[Allies]);
+        const auto occupancy = ((Board[Allies] | Board[Enemies]) ^ origin ^ (Board.en_passant+Down))
+                             | Board.en_passant;
+
+        return ((GetAttack<Bishops>::On(king, occupancy) & (Board[Bishops] | Board[Queens]))
+             |  (GetAttack<Rooks  >::On(king, occupancy) & (Board[Rooks  ] | Board[Queens])))
+             &  Board[Enemies];
+    }
+
+    // Pushes, captures and promotions of every pawn in `pawns` with one shift and one mask
+    // per kind of move; origins come back from the targets by undoing the shift.
+    template <EnumColor Color, EnumGenType Type> static inline
+    void PawnMoves(GameState& Board, MoveList::iterator& Moves, Bitboard pawns, Bitboard mask) noexcept {
+        constexpr auto Allies = Color, Enemies = ~Allies;
+        constexpr auto Noisy  = (Type != GenQuiets), Silent = (Type != GenCaptures);
+        constexpr auto PromotionRank = (Allies == White ? Rank_8 : Rank_1);
+        constexpr auto DoubleRank    = (Allies == White ? Rank_3 : Rank_6); // after one step
+        constexpr auto Up            = (Allies == White ? North  : South );
+        const auto empty = ~(Board[Allies] | Board[Enemies]);
 
-            auto empty = ~occupancy;
-            EnumSquare target = origin + Up;
-            if (target & empty) {
-                *Moves++ = Move::Encode<Piece>(origin, target, Quiet);
-                if ((origin & StartingRank) && ((target+Up) & empty))
-                    *Moves++ = Move::Encode<Piece>(origin, (target+Up), DoublePush);
-                if (target & PromotionRank) { --Moves;
-                    *Moves++ = Move::Encode<Piece>(origin, target, PromotionKnight);
-                    *Moves++ = Move::Encode<Piece>(origin, target, PromotionBishop);
-                    *Moves++ = Move::Encode<Piece>(origin, target, PromotionRook  );
-                    *Moves++ = Move::Encode<Piece>(origin, target, PromotionQueen );
+        if constexpr(Noisy) {
+            const auto west = Utils::ShiftTo<Up|West>(pawns) & Board[Enemies] & mask;
+            const auto east = Utils::ShiftTo<Up|East>(pawns) & Board[Enemies] & mask;
+            const auto push = Utils::ShiftTo<Up     >(pawns) & empty & mask & PromotionRank;
+            Serialize<Up|West>(Moves, west & ~PromotionRank, Capture);
+            Serialize<Up|East>(Moves, east & ~PromotionRank, Capture);
+            Promotions<Up|West>(Moves, west & PromotionRank, Capture);
+            Promotions<Up|East>(Moves, east & PromotionRank, Capture);
+            Promotions<Up     >(Moves, push, Quiet);
+
+            if (Board.en_passant && ((Board.en_passant | (Board.en_passant-Up)) & mask)) {
+                auto takers = GetAttack<Enemies, Pawns>::On(Board.en_passant) & pawns;
+                while (takers) {
+                    const auto origin = Utils::PopLS1B(takers);
+                    if (Type != GenLegal || !EnPassantDiscovers<Allies>(Board, origin))
+                        *Moves++ = Move::Encode<Pawns>(origin, Board.en_passant, EnPassant);
                 }
             }
+        }
+
+        if constexpr(Silent) {
+            const auto single = Utils::ShiftTo<Up>(pawns) & empty;
+            const auto twice  = Utils::ShiftTo<Up>(single & DoubleRank) & empty & mask;
+            Serialize<Up   >(Moves, single & mask & ~PromotionRank, Quiet);
+            Serialize<Up|Up>(Moves, twice, DoublePush);
+        }
+    }
+
+    template <EnumCompass Shift> static inline
+    void Serialize(MoveList::iterator& Moves, Bitboard targets, EnumMoveFlags flags) noexcept {
+        while (targets) {
+            const auto target = Utils::PopLS1B(targets);
+            *Moves++ = Move::Encode<Pawns>(target - Shift, target, flags);
+        }
+    }
+
+    template <EnumCompass Shift> static inline
+    void Promotions(MoveList::iterator& Moves, Bitboard targets, EnumMoveFlags flags) noexcept {
+        while (targets) {
+            const auto target = Utils::PopLS1B(targets), origin = target - Shift;
+            *Moves++ = Move::Encode<Pawns>(origin, target, PromotionKnight | flags);
+            *Moves++ = Move::Encode<Pawns>(origin, target, PromotionBishop | flags);
+            *Moves++ = Move::Encode<Pawns>(origin, target, PromotionRook   | flags);
+            *Moves++ = Move::Encode<Pawns>(origin, target, PromotionQueen  | flags);
+        }
+    }
+
+    // `mask` restricts the destination squares, evasions use it for the checker and the
+    // squares between it and the king. The rest of the target set is picked at compile time.
+    // Pieces in `pinned` may only move along the line joining them to their king.
+    template <EnumColor Color, EnumPiece Piece, EnumGenType Type> static inline
+    auto PseudoLegal(GameState& Board, MoveList::iterator& Moves, NodeAttacks<Color>& Node,
+                     Bitboard mask=~0ULL, Bitboard pinned=0ULL) noexcept {
+        constexpr auto Allies = Color, Enemies = ~Allies;
+        constexpr auto Noisy  = (Type != GenQuiets), Silent = (Type != GenCaptures);
+        auto set       = (Board[Allies] & Board[Piece  ]);
+        auto occupancy = (Board[Allies] | Board[Enemies]);
+        auto targets   = (Type == GenCaptures ?  Board[Enemies] :
+                          Type == GenQuiets   ? ~occupancy      : ~Board[Allies]) & mask;
+
+        if constexpr(Piece == Knights) set &= ~pinned;
+
+        /////////////////////////////////////// PAWNS ////////////////////////////////////////
 
-            if (Board.en_passant)
-                if (GetAttack<Allies, Piece>::On(origin) & Board.en_passant)
-                    *Moves++ = Move::Encode<Piece>(origin, Board.en_passant, EnPassant);
+        // Set-wise: free pawns all at once, each pinned one on its own with its pin line.
+        if constexpr(Piece == Pawns) {
+            PawnMoves<Allies, Type>(Board, Moves, set & ~pinned, mask);
+            for (auto pins = set & pinned; pins; ) {
+                const auto origin = Utils::PopLS1B(pins);
+                PawnMoves<Allies, Type>(Board, Moves, Bitboard(0) | origin,
+                                        mask & GetRay::Line(Node.KingSquare(), origin));
+            } return;
         }
 
+        while (set) {
+        EnumSquare origin = Utils::PopLS1B(set);
+        const auto legal  = (origin & pinned) ? mask & GetRay::Line(Node.KingSquare(), origin) : mask;
+
         /////////////////////////////////// KNIGHTS / KING ///////////////////////////////////
 
         if constexpr(Piece == Knights || Piece == King) {
-            auto attacks = GetAttack<Piece>::On(origin) & ~Board[Allies];
+            auto attacks = GetAttack<Piece>::On(origin) & targets;
             while (attacks) {
                 auto attack = Utils::PopLS1B(attacks);
-                if (attack & ~Board[Enemies])
+                if (Silent && (!Noisy || attack & ~Board[Enemies]))
                      *Moves++ = Move::Encode<Piece>(origin, attack, Quiet);
                 else *Moves++ = Move::Encode<Piece>(origin, attack, Capture);
             }
 
-            if constexpr(Piece == King) {
+            if constexpr(Piece == King && Silent && Type != GenEvasions) {
                 constexpr auto king = (Allies == White ? e1:e8);
 
                 constexpr auto Kk = (Allies == White ? 0 : 2);
                 if (Board.castling_rights[Kk]) {
                     if (!(((king+1) | (king+2)) & occupancy))
-                        if (!GameState::InCheck<Allies>(Board, king)
-                        &&  !GameState::InCheck<Allies>(Board, king+1)
-                        &&  !GameState::InCheck<Allies>(Board, king+2))
+                        if (Node.CanCastleThrough((king+1) | (king+2)))
                             *Moves++ = Move::Encode<Piece>(origin, king+2, CastleKing);
                 }
 
                 constexpr auto Qq = (Allies == White ? 1 : 3);
                 if (Board.castling_rights[Qq]) {
                     if (!(((king-1) | (king-2) | (king-3)) & occupancy))
-                        if (!GameState::InCheck<Allies>(Board, king)
-                        &&  !GameState::InCheck<Allies>(Board, king-1)
-                        &&  !GameState::InCheck<Allies>(Board, king-2))
+                        if (Node.CanCastleThrough((king-1) | (king-2)))
                             *Moves++ = Move::Encode<Piece>(origin, king-2, CastleQueen);
                 }
             }
@@ -116,10 +323,10 @@ private:
 
         if constexpr(Piece == Bishops || Piece == Rooks || Piece == Queens) {
             auto attacks = Bitboard(0);
-            attacks = GetAttack<Piece>::On(origin, occupancy) & ~Board[Allies];
+            attacks = GetAttack<Piece>::On(origin, occupancy) & targets & legal;
             while (attacks) {
                 auto attack = Utils::PopLS1B(attacks);
-                if (attack & ~Board[Enemies])
+                if (Silent && (!Noisy || attack & ~Board[Enemies]))
                      *Moves++ = Move::Encode<Piece>(origin, attack, Quiet);
                 else *Moves++ = Move::Encode<Piece>(origin, attack, Capture);
             }
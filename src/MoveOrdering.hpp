@@ -5,6 +5,12 @@
 
 #include <algorithm>
 #include <cstring>
+#include <atomic>
+#include <cstdlib>
+
+#define HISTORY_MAX 16384 // history scores saturate towards +-HISTORY_MAX
+
+using MoveScores = std::array<int, 218>; // one per entry of a MoveList
 
 class PrincipalVariation final { friend class Search;
 public:
@@ -12,6 +18,11 @@ public:
     [[nodiscard]] static inline auto  GetBestMove()              { return table[0][0];   }
     [[nodiscard]] static inline auto& GetMove(std::uint8_t ply)  { return table[0][ply]; }
 
+    // The reply the principal variation expects, an empty move when it ends at the root.
+    [[nodiscard]] static inline auto  GetPonderMove()            {
+        return length[0] > 1 ? table[0][1] : Move { };
+    }
+
     [[nodiscard]] static inline auto ToString() noexcept {
         std::stringstream pv;
         for (auto index = 0; index < length[0]; ++index)
@@ -21,8 +32,8 @@ public:
 
 
 private:
-    static inline std::array<std::array<Move, 64>, 64> table  { };
-    static inline std::array<std::uint8_t, 64>         length { };
+    static inline thread_local std::array<std::array<Move, 64>, 64> table  { };
+    static inline thread_local std::array<std::uint8_t, 64>         length { };
 
     static inline auto UpdateLength(std::uint8_t ply) noexcept { length[ply] = ply; }
 
@@ -36,41 +47,116 @@ private:
     ~PrincipalVariation()=delete;
 };
 
-class MoveOrdering final {
+class MoveOrdering final { friend class Search;
 public:
 
-    static inline int ScoreMove
-    (const GameState& Board, Move& move, std::uint8_t ply) noexcept {
-        if (*reinterpret_cast<int*>(&move) ==
-            *reinterpret_cast<int*>(&PrincipalVariation::GetMove(ply-1))) {
-            return 100;
-        } else if (move.flags & Capture) {
-            auto victim = Pawns;
-            for (int piece = Pawns; piece != King; ++piece) {
-                if (move.target & Board[piece]) {
-                    victim = static_cast<EnumPiece>(piece);
-                    break;
-                }
-            } return mvv_lva_table[move.piece-2][victim-2];
-        } else return 0;
+    [[nodiscard]] static inline auto& GetKillers(std::uint8_t ply) noexcept { return killers[ply]; }
+
+    // Quiet moves that caused a beta cutoff at this ply, most recent first.
+    static inline auto UpdateKillers(Move move, std::uint8_t ply) noexcept {
+        if (killers[ply][0] != move)
+            killers[ply][1] = killers[ply][0], killers[ply][0] = move;
+    }
+
+    // Move that led to the node at `ply + 1`, an empty one for a null move.
+    static inline auto SetPlayed(Move move, std::uint8_t ply) noexcept { played[ply] = move; }
+
+    // Quiet reply that last refuted the move played just before `ply`.
+    [[nodiscard]] static inline Move GetCountermove(EnumColor color, std::uint8_t ply) noexcept {
+        if (!ply || !played[ply-1].piece) return Move { };
+        const auto previous = played[ply-1];
+        return countermoves[color][previous.piece-2][previous.target];
     }
 
-    static inline auto SortAll
-    (const GameState& Board, MoveList& move_list, int nmoves, std::uint8_t ply) noexcept {
-        std::sort(&move_list[0], &move_list[nmoves], [&](Move& a, Move& b) {
-            return MoveOrdering::ScoreMove(Board, a, ply) > MoveOrdering::ScoreMove(Board, b, ply);
-        });
+    // History of quiet moves by side, origin and target (butterfly board). Bonuses shrink
+    // as a score nears HISTORY_MAX, so old cutoffs fade instead of saturating the table.
+    [[nodiscard]] static inline int GetHistory(EnumColor color, Move move) noexcept {
+        return history[color][move.origin][move.target];
     }
 
-    static inline auto SwapFirst
-    (const GameState& Board, MoveList& move_list, int nmoves, std::uint8_t ply) {
-        auto res = std::max_element(&move_list[0], &move_list[nmoves], [&](Move& a, Move& b) {
-            return MoveOrdering::ScoreMove(Board, a, ply) < MoveOrdering::ScoreMove(Board, b, ply);});
-        std::swap(move_list[0], move_list[std::distance(&move_list[0], res)]);
+    // On a quiet beta cutoff: `move` is rewarded, the quiets searched before it are penalised.
+    static inline auto UpdateQuiets(EnumColor color, Move move, const Move* tried, int ntried,
+                                    int depth, std::uint8_t ply) noexcept {
+        const auto bonus = std::min(depth * depth * 16, HISTORY_MAX / 4);
+        Gravity(history[color][move.origin][move.target], bonus);
+        for (auto index = 0; index < ntried; ++index)
+            Gravity(history[color][tried[index].origin][tried[index].target], -bonus);
+
+        UpdateKillers(move, ply);
+        if (ply && played[ply-1].piece)
+            countermoves[color][played[ply-1].piece-2][played[ply-1].target] = move;
     }
 
+    // Quiets by history, the countermove ahead of all of them.
+    [[nodiscard]] static inline int ScoreQuiet(EnumColor color, Move move, Move countermove) noexcept {
+        return move == countermove ? HISTORY_MAX + 1 : GetHistory(color, move);
+    }
+
+    // Captures by MVV-LVA, everything else after them.
+    [[nodiscard]] static inline int ScoreMove(const GameState& Board, Move move) noexcept {
+        if (!(move.flags & Capture)) return 0;
+        const auto victim = Board.PieceOn(move.target);
+        return mvv_lva_table[move.piece-2][(victim ? victim : Pawns)-2];
+    }
+
+    // Every move is scored once, ahead of the search, and the principal variation move
+    // of this ply goes first. The pickers below only compare the numbers.
+    static inline auto ScoreAll(const GameState& Board, const MoveList& moves, MoveScores& scores,
+                                int begin, int end, std::uint8_t ply) noexcept {
+        const auto pv_move = PrincipalVariation::GetMove(ply);
+        for (auto index = begin; index < end; ++index)
+            scores[index] = moves[index] == pv_move ? 100 : ScoreMove(Board, moves[index]);
+    }
+
+    // Selection sort step: moves are rarely all searched, sorting them fully is wasted.
+    static inline Move PickBest(MoveList& moves, MoveScores& scores, int current, int end) noexcept {
+        auto best = current;
+        for (auto index = current+1; index < end; ++index)
+            if (scores[index] > scores[best]) best = index;
+        std::swap(moves[best],  moves[current]);
+        std::swap(scores[best], scores[current]);
+        return moves[current];
+    }
+
+    //////////////////////////////////////// STATISTICS ////////////////////////////////////////
+
+    // Beta cutoffs, and those produced by the first legal move searched: the closer the
+    // ratio is to one, the better the ordering. Counted per thread like EvalCache.
+    static inline thread_local std::uint64_t cutoffs, first_cutoffs;
+
+    static inline void Flush() noexcept {
+        total_cutoffs      .fetch_add(cutoffs,       std::memory_order_relaxed);
+        total_first_cutoffs.fetch_add(first_cutoffs, std::memory_order_relaxed);
+        cutoffs = first_cutoffs = 0;
+    }
+
+    static inline void ResetStatistics() noexcept {
+        cutoffs = first_cutoffs = 0;
+        total_cutoffs = total_first_cutoffs = 0;
+    }
+
+    // Permille, like EvalCache::HitRate.
+    [[nodiscard]] static inline int FirstCutoffRate() noexcept {
+        const auto total = total_cutoffs.load(std::memory_order_relaxed);
+        return total ? int(total_first_cutoffs.load(std::memory_order_relaxed) * 1000 / total) : 0;
+    }
+
+    [[nodiscard]] static inline std::uint64_t Cutoffs() noexcept {
+        return total_cutoffs.load(std::memory_order_relaxed);
+    }
 
 private:
+    static inline thread_local std::array<std::array<Move, 2>, 64>                     killers      { };
+    static inline thread_local std::array<Move, 64>                                    played       { };
+    static inline thread_local std::array<std::array<std::array<Move, 64>, 6>, 2>      countermoves { };
+    static inline thread_local std::array<std::array<std::array<std::int16_t, 64>, 64>, 2> history  { };
+
+    static inline std::atomic<std::uint64_t> total_cutoffs = 0, total_first_cutoffs = 0;
+
+    static inline void Gravity(std::int16_t& entry, int bonus) noexcept {
+        entry += bonus - entry * std::abs(bonus) / HISTORY_MAX;
+    }
+
     static constexpr std::array<std::array<std::uint8_t, 6>, 6> mvv_lva_table {
     //    P   N   B   R   Q   K
         {{15, 25, 35, 45, 55, 65},  // P
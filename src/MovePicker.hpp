@@ -0,0 +1,103 @@
+#pragma once
+
+#include "MoveGeneration.hpp"
+#include "MoveOrdering.hpp"
+#include "NodeAttacks.hpp"
+#include "GameState.hpp"
+#include "Move.hpp"
+
+#include <array>
+
+enum EnumPickerStage: std::uint8_t {
+    StageHashMove,
+    StageGenerateCaptures,
+    StageCaptures,
+    StageKillers,
+    StageGenerateQuiets,
+    StageQuiets,
+    StageDone
+};
+
+// Yields the moves of a node lazily, in the order they are most likely to cut: hash
+// move, captures by MVV-LVA, killers, quiets by countermove then history. A stage is
+// only generated once the previous one is exhausted, so a cutoff on the hash move costs
+// no generation at all.
+template <EnumColor Color>
+class MovePicker final {
+public:
+    MovePicker(GameState& Board, NodeAttacks<Color>& Node, Move hash_move, std::uint8_t ply) noexcept
+        : Board(Board), Node(Node), hash_move(hash_move), killers(MoveOrdering::GetKillers(ply)),
+          countermove(MoveOrdering::GetCountermove(Color, ply)), ply(ply) { }
+
+    [[nodiscard]] inline Move Next() noexcept {
+        switch (stage) {
+        case StageHashMove: ++stage;
+            if (MoveGeneration::IsPseudoLegal<Color>(Board, hash_move, Node))
+                return hash_move;
+            [[fallthrough]];
+
+        case StageGenerateCaptures: ++stage;
+            Generate<GenCaptures>();
+            MoveOrdering::ScoreAll(Board, moves, scores, current, end, ply);
+            [[fallthrough]];
+
+        case StageCaptures:
+            while (current < end) {
+                auto move = PickBest();
+                if (move != hash_move) return move;
+            } ++stage;
+            [[fallthrough]];
+
+        case StageKillers:
+            while (killer < killers.size()) {
+                auto move = killers[killer++];
+                if (move != hash_move && !(move.flags & (Capture|PromotionKnight))
+                &&  MoveGeneration::IsPseudoLegal<Color>(Board, move, Node))
+                    return move;
+            } ++stage;
+            [[fallthrough]];
+
+        case StageGenerateQuiets: ++stage;
+            Generate<GenQuiets>();
+            for (auto index = current; index < end; ++index)
+                scores[index] = MoveOrdering::ScoreQuiet(Color, moves[index], countermove);
+            [[fallthrough]];
+
+        case StageQuiets:
+            while (current < end) {
+                auto move = PickBest();
+                if (move != hash_move && move != killers[0] && move != killers[1])
+                    return move;
+            } ++stage;
+            [[fallthrough]];
+
+        default: return Move { };
+        }
+    }
+
+private:
+    GameState&                          Board;
+    NodeAttacks<Color>&                 Node;
+    const Move                          hash_move;
+    const std::array<Move, 2>           killers;
+    const Move                          countermove;
+    const std::uint8_t                  ply;
+
+    std::uint8_t                        stage   = StageHashMove;
+    std::uint8_t                        killer  = 0;
+    int                                 current = 0;
+    int                                 end     = 0;
+    MoveList                            moves;
+    MoveScores                          scores;
+
+    template <EnumGenType Type>
+    inline auto Generate() noexcept {
+        auto iterator = moves.begin();
+        MoveGeneration::Generate<Color, Type>(Board, iterator, Node);
+        current = 0, end = std::distance(moves.begin(), iterator);
+    }
+
+    inline auto PickBest() noexcept {
+        return MoveOrdering::PickBest(moves, scores, current++, end);
+    }
+};
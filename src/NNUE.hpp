@@ -0,0 +1,226 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+#include "GameState.hpp"
+#include "PieceSquare.hpp"
+#include "Utils.hpp"
+
+#include <fstream>
+#include <string>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <algorithm>
+
+#if defined(__AVX2__) || defined(__SSE4_1__)
+#include <immintrin.h>
+#endif
+
+// HalfKA: one feature per (own king square, piece colour relative to the perspective,
+// piece type, square), both squares seen from the perspective's side of the board.
+#define NNUE_INPUTS       (64 * 12 * 64)
+#define NNUE_MAGIC        0x4E4E4543 // "CENN"
+#define NNUE_VERSION      1
+#define NNUE_DEFAULT_FILE "chess-engine.nnue"
+
+// Network: NNUE_INPUTS -> 2 x NNUE_HIDDEN (int16, clipped ReLU 0..127) -> 1 (int8 weights).
+//
+// File layout, little endian:
+//   u32 magic, u32 version, u32 inputs, u32 hidden,
+//   i16 feature_weights[inputs][hidden], i16 feature_bias[hidden],
+//   i8  output_weights[2*hidden] (side to move first), i32 output_bias, i32 output_scale
+//
+// The evaluation is (dot + output_bias) * output_scale / 1024 centipawns.
+
+class NNUE final {
+public:
+    using Layer = std::array<std::int16_t, NNUE_HIDDEN>;
+
+    static inline bool enabled = false;
+
+    // Synthesizes the embedded network, then replaces it with `path` if there is one.
+    static inline void Init(const std::string& path=NNUE_DEFAULT_FILE) noexcept {
+        Default(); (void)Load(path);
+    }
+
+    // Keeps the current network and returns false when the file is missing or malformed.
+    static inline bool Load(const std::string& path) noexcept {
+        std::ifstream file(path, std::ios::binary);
+        if (!file) return false;
+
+        std::uint32_t header[4] { };
+        file.read(reinterpret_cast<char*>(header), sizeof(header));
+        if (!file || header[0] != NNUE_MAGIC || header[1] != NNUE_VERSION
+        ||  header[2] != NNUE_INPUTS || header[3] != NNUE_HIDDEN)
+            return false;
+
+        auto Loaded = std::make_unique<Network>();
+        file.read(reinterpret_cast<char*>(Loaded->feature_weights.data()),
+                  sizeof(Loaded->feature_weights));
+        file.read(reinterpret_cast<char*>(Loaded->feature_bias.data()),
+                  sizeof(Loaded->feature_bias));
+        file.read(reinterpret_cast<char*>(Loaded->output_weights.data()),
+                  sizeof(Loaded->output_weights));
+        file.read(reinterpret_cast<char*>(&Loaded->output_bias),  sizeof(Loaded->output_bias));
+        file.read(reinterpret_cast<char*>(&Loaded->output_scale), sizeof(Loaded->output_scale));
+        if (!file) return false;
+
+        std::memcpy(&Net, Loaded.get(), sizeof(Network));
+        return true;
+    }
+
+    // Recomputes both perspectives from scratch.
+    static inline void Refresh(GameState& Board) noexcept {
+        Refresh<White>(Board); Refresh<Black>(Board);
+    }
+
+    template <EnumColor Perspective>
+    static inline void Refresh(GameState& Board) noexcept {
+        auto& accumulator = Board.nnue.values[Perspective];
+        accumulator = Net.feature_bias;
+        const auto king = Utils::IndexLS1B(Board[King] & Board[Perspective]);
+        for (auto set = Board[White] | Board[Black]; set; ) {
+            const auto square = Utils::PopLS1B(set);
+            const auto color  = (Board[Black] & square) ? Black : White;
+            Add(accumulator, Feature<Perspective>(king, color, Board.PieceOn(square), square));
+        }
+    }
+
+    // Side-to-move relative score in centipawns.
+    template <EnumColor Color> [[nodiscard]]
+    static inline int Evaluate(const GameState& Board) noexcept {
+        const auto dot = Output(Board.nnue.values[ Color], Net.output_weights.data())
+                       + Output(Board.nnue.values[~Color], Net.output_weights.data() + NNUE_HIDDEN);
+        return (dot + Net.output_bias) * Net.output_scale / 1024;
+    }
+
+    // Input index of a piece for one perspective, given that perspective's king square.
+    template <EnumColor Perspective> [[nodiscard]]
+    static constexpr inline std::size_t Feature
+    (EnumSquare king, EnumColor color, EnumPiece piece, EnumSquare square) noexcept {
+        constexpr auto Orient = (Perspective == White ? 0 : 56);
+        const auto relative = (color == Perspective ? 0 : 6);
+        return ((std::size_t(int(king) ^ Orient) * 12 + relative + piece-2) * 64)
+             + (int(square) ^ Orient);
+    }
+
+    //////////////////////////////////////// KERNELS ////////////////////////////////////////
+
+    static inline void Add(Layer& accumulator, std::size_t feature) noexcept {
+        const auto& weights = Net.feature_weights[feature];
+        #if defined(__AVX2__)
+        for (auto i = 0; i < NNUE_HIDDEN; i += 16) {
+            auto* lane = reinterpret_cast<__m256i*>(&accumulator[i]);
+            _mm256_store_si256(lane, _mm256_add_epi16(_mm256_load_si256(lane),
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(&weights[i]))));
+        }
+        #elif defined(__SSE4_1__)
+        for (auto i = 0; i < NNUE_HIDDEN; i += 8) {
+            auto* lane = reinterpret_cast<__m128i*>(&accumulator[i]);
+            _mm_store_si128(lane, _mm_add_epi16(_mm_load_si128(lane),
+                _mm_load_si128(reinterpret_cast<const __m128i*>(&weights[i]))));
+        }
+        #else
+        for (auto i = 0; i < NNUE_HIDDEN; ++i) accumulator[i] += weights[i];
+        #endif
+    }
+
+    static inline void Sub(Layer& accumulator, std::size_t feature) noexcept {
+        const auto& weights = Net.feature_weights[feature];
+        #if defined(__AVX2__)
+        for (auto i = 0; i < NNUE_HIDDEN; i += 16) {
+            auto* lane = reinterpret_cast<__m256i*>(&accumulator[i]);
+            _mm256_store_si256(lane, _mm256_sub_epi16(_mm256_load_si256(lane),
+                _mm256_load_si256(reinterpret_cast<const __m256i*>(&weights[i]))));
+        }
+        #elif defined(__SSE4_1__)
+        for (auto i = 0; i < NNUE_HIDDEN; i += 8) {
+            auto* lane = reinterpret_cast<__m128i*>(&accumulator[i]);
+            _mm_store_si128(lane, _mm_sub_epi16(_mm_load_si128(lane),
+                _mm_load_si128(reinterpret_cast<const __m128i*>(&weights[i]))));
+        }
+        #else
+        for (auto i = 0; i < NNUE_HIDDEN; ++i) accumulator[i] -= weights[i];
+        #endif
+    }
+
+private:
+    struct alignas(64) Network {
+        std::array<Layer, NNUE_INPUTS>             feature_weights;
+        Layer                                      feature_bias;
+        std::array<std::int8_t, 2 * NNUE_HIDDEN>   output_weights;
+        std::int32_t                               output_bias;
+        std::int32_t                               output_scale;
+    };
+
+    static inline Network Net;
+
+    // Clipped ReLU of one perspective dotted with its int8 output weights.
+    [[nodiscard]] static inline int Output(const Layer& accumulator, const std::int8_t* weights) noexcept {
+        #if defined(__AVX2__)
+        const auto zero = _mm256_setzero_si256(), max = _mm256_set1_epi16(127);
+        auto sum = _mm256_setzero_si256();
+        for (auto i = 0; i < NNUE_HIDDEN; i += 16) {
+            const auto input  = _mm256_min_epi16(_mm256_max_epi16(_mm256_load_si256(
+                reinterpret_cast<const __m256i*>(&accumulator[i])), zero), max);
+            const auto weight = _mm256_cvtepi8_epi16(_mm_loadu_si128(
+                reinterpret_cast<const __m128i*>(weights + i)));
+            sum = _mm256_add_epi32(sum, _mm256_madd_epi16(input, weight));
+        }
+        auto half = _mm_add_epi32(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0x4E));
+        half = _mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1));
+        return _mm_cvtsi128_si32(half);
+        #elif defined(__SSE4_1__)
+        const auto zero = _mm_setzero_si128(), max = _mm_set1_epi16(127);
+        auto sum = _mm_setzero_si128();
+        for (auto i = 0; i < NNUE_HIDDEN; i += 8) {
+            const auto input  = _mm_min_epi16(_mm_max_epi16(_mm_load_si128(
+                reinterpret_cast<const __m128i*>(&accumulator[i])), zero), max);
+            const auto weight = _mm_cvtepi8_epi16(_mm_loadl_epi64(
+                reinterpret_cast<const __m128i*>(weights + i)));
+            sum = _mm_add_epi32(sum, _mm_madd_epi16(input, weight));
+        }
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0x4E));
+        sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, 0xB1));
+        return _mm_cvtsi128_si32(sum);
+        #else
+        auto sum = 0;
+        for (auto i = 0; i < NNUE_HIDDEN; ++i)
+            sum += std::clamp<int>(accumulator[i], 0, 127) * weights[i];
+        return sum;
+        #endif
+    }
+
+    ///////////////////////////////////// DEFAULT NETWORK ////////////////////////////////////
+
+    // The embedded network is an approximate placeholder so that UseNNUE works without a
+    // file: one hidden unit per (relative colour, piece type, board half), fed with
+    // material + PST / 8, and read back with +1/-1 on the side to move's perspective only.
+    // It is not the classical evaluation: phases are averaged instead of tapered, and the
+    // 0..127 clip saturates a unit holding a lot of material (eight pawns on one half score
+    // 904 instead of 1015), while a negative sum reads as zero. Load a trained net through
+    // EvalFile.
+    static inline void Default() noexcept {
+        std::memset(&Net, 0, sizeof(Network));
+        for (EnumSquare king = a1; king <= h8; ++king)
+        for (auto relative = 0; relative < 2; ++relative)
+        for (auto piece = 0; piece < 6; ++piece)
+        for (EnumSquare square = a1; square <= h8; ++square) {
+            // Squares are already oriented: an enemy piece reads its table mirrored.
+            const auto own   = relative ? EnumSquare(int(square) ^ 56) : square;
+            const auto score = PieceSquare::Get(White, EnumPiece(piece+2), own);
+            const auto value = (MgScore(score) + EgScore(score)) / 2;
+            const auto unit  = relative * 12 + piece * 2 + (square % 8 >= 4);
+            Net.feature_weights[(king * 12 + relative * 6 + piece) * 64 + square][unit] =
+                std::int16_t((value + 4) / 8);
+        }
+        for (auto unit = 0; unit < 24; ++unit)
+            Net.output_weights[unit] = unit < 12 ? 1 : -1;
+        Net.output_bias  = 0;
+        Net.output_scale = 8 * 1024;
+    }
+
+     NNUE()=delete;
+    ~NNUE()=delete;
+};
@@ -0,0 +1,120 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+#include "GameState.hpp"
+#include "GetAttack.hpp"
+#include "AttackMap.hpp"
+#include "Utils.hpp"
+#include "Move.hpp"
+
+#include <atomic>
+#include <cstdint>
+
+// InCheck calls answered from a NodeAttacks instead, summed over both colours.
+class NodeStatistics final {
+public:
+    // Counted per thread, folded into the total when a thread is done searching.
+    static inline thread_local std::uint64_t saved;
+
+    static inline void Flush() noexcept {
+        total_saved.fetch_add(saved, std::memory_order_relaxed);
+        saved = 0;
+    }
+
+    static inline void ResetStatistics() noexcept {
+        saved = 0, total_saved = 0;
+    }
+
+    [[nodiscard]] static inline std::uint64_t Saved() noexcept {
+        return total_saved.load(std::memory_order_relaxed);
+    }
+
+private:
+    static inline std::atomic<std::uint64_t> total_saved = 0;
+
+     NodeStatistics()=delete;
+    ~NodeStatistics()=delete;
+};
+
+// What the side to move is up against in one position: the pieces giving check, its own
+// pinned pieces, and every square the enemy attacks with sliders seeing through our king.
+// Each is worked out on first use and kept for the rest of the node, so the generator,
+// castling and the legality of played moves ask once instead of calling InCheck each time.
+// Only valid while the board is back in the position it was built on.
+template <EnumColor Color>
+class NodeAttacks final {
+public:
+    explicit NodeAttacks(GameState& Board) noexcept
+        : Board(Board), king(Utils::IndexLS1B(Board[King] & Board[Color])) { }
+
+    [[nodiscard]] inline EnumSquare KingSquare() const noexcept { return king; }
+
+    [[nodiscard]] inline bool InCheck() noexcept {
+        if (known & KnownCheckers) ++NodeStatistics::saved;
+        return Checkers();
+    }
+
+    [[nodiscard]] inline Bitboard Checkers() noexcept {
+        if (!(known & KnownCheckers))
+            checkers = GameState::Attackers<Color>(Board, king), known |= KnownCheckers;
+        return checkers;
+    }
+
+    // Allied pieces that are the only blocker between their king and an enemy slider.
+    [[nodiscard]] inline Bitboard Pinned() noexcept {
+        if (!(known & KnownPinned)) {
+            constexpr auto Enemies = ~Color;
+            const auto occupancy = Board[Color] | Board[Enemies];
+            auto snipers = ((GetAttack<Bishops>::On(king, Board[Enemies]) & (Board[Bishops] | Board[Queens]))
+                         |  (GetAttack<Rooks  >::On(king, Board[Enemies]) & (Board[Rooks  ] | Board[Queens])))
+                         &  Board[Enemies];
+            pinned = 0ULL;
+            while (snipers) {
+                const auto blockers = GetRay::Between(king, Utils::PopLS1B(snipers)) & occupancy;
+                if (Utils::PopCount(blockers) == 1) pinned |= blockers & Board[Color];
+            } known |= KnownPinned;
+        } return pinned;
+    }
+
+    // Every square attacked by ~Color, sliders seeing through the allied king so that it
+    // cannot step back along the line of a check.
+    [[nodiscard]] inline Bitboard Threats() noexcept {
+        if (!(known & KnownThreats))
+            threats = AttackMap::Of<~Color>(Board, true, Board[King] & Board[Color]), known |= KnownThreats;
+        return threats;
+    }
+
+    // Castling: the king is not in check and none of `squares` is attacked, one InCheck
+    // less per square.
+    [[nodiscard]] inline bool CanCastleThrough(Bitboard squares) noexcept {
+        if (InCheck()) return false;
+        NodeStatistics::saved += Utils::PopCount(squares);
+        return !(Threats() & squares);
+    }
+
+    // Whether `move`, pseudo-legal here, is known to leave the king safe, so that Make can
+    // skip its own InCheck. False only means it has to be checked, en passant always is.
+    [[nodiscard]] inline bool Safe(const Move& move) noexcept {
+        const auto [piece, origin, target, flags] = move;
+        auto safe = false;
+        if (piece == King)
+            safe = (flags == CastleKing || flags == CastleQueen) || !(Threats() & target);
+        else if (flags != EnPassant && (!(Pinned() & origin) || (GetRay::Line(king, origin) & target))) {
+            const auto attackers = Checkers();
+            safe = !attackers || (!(attackers & (attackers - 1)) && (target &
+                (attackers | GetRay::Between(king, Utils::IndexLS1B(attackers)))));
+        }
+        NodeStatistics::saved += safe;
+        return safe;
+    }
+
+private:
+    enum : std::uint8_t { KnownCheckers = 1, KnownPinned = 2, KnownThreats = 4 };
+
+    GameState&       Board;
+    const EnumSquare king;
+    std::uint8_t     known    = 0;
+    Bitboard         checkers = 0ULL;
+    Bitboard         pinned   = 0ULL;
+    Bitboard         threats  = 0ULL;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+#include "GameState.hpp"
+#include "PieceSquare.hpp"
+#include "Utils.hpp"
+
+#include <array>
+#include <cstdint>
+
+#define PAWN_HASH_ENTRIES 8192 // per search thread, a power of two
+
+// Everything the evaluation needs that depends on pawns alone, one cache line per entry.
+struct alignas(64) PawnEntry {
+    std::uint64_t           key;
+    Score                   score;   // structure terms, White's point of view
+    std::array<Bitboard, 2> attacks; // squares attacked by each side's pawns right now
+    std::array<Bitboard, 2> spans;   // squares each side's pawns could ever attack
+};
+
+// Pawn structure only changes on pawn moves, captures of pawns and promotions, so it
+// is evaluated once per pawn configuration and looked up by GameState::pawn_hash.
+// Tables are per thread: Lazy SMP helpers never contend and entries need no locking.
+class PawnHash final {
+public:
+    [[nodiscard]] static inline const PawnEntry& Probe(const GameState& Board) noexcept {
+        auto& Entry = Table[Board.pawn_hash & (PAWN_HASH_ENTRIES-1)];
+        if (Entry.key != Board.pawn_hash) {
+            Entry.key   = Board.pawn_hash;
+            Entry.score = Evaluate<White>(Board, Entry) - Evaluate<Black>(Board, Entry);
+        } return Entry;
+    }
+
+    // Pushes every bit of `bitboard` to the end of its file, towards `Direction`.
+    template <EnumCompass Direction>
+    [[nodiscard]] static constexpr inline Bitboard Fill(Bitboard bitboard) noexcept {
+        if constexpr(Direction == North) {
+            bitboard |= bitboard <<  8; bitboard |= bitboard << 16; bitboard |= bitboard << 32;
+        } else {
+            bitboard |= bitboard >>  8; bitboard |= bitboard >> 16; bitboard |= bitboard >> 32;
+        } return bitboard;
+    }
+
+private:
+    static constexpr Score Doubled  = S(-10, -20);
+    static constexpr Score Isolated = S(-10, -15);
+    static constexpr Score Backward = S( -8, -10);
+    static constexpr Score Passed[8] {
+        S(0, 0), S(0, 5), S(5, 10), S(10, 20), S(20, 35), S(35, 60), S(60, 90), S(0, 0)
+    };
+
+    // Set-wise over the whole pawn chain, only passed pawns are looked at one by one.
+    template <EnumColor Color>
+    [[nodiscard]] static inline Score Evaluate(const GameState& Board, PawnEntry& Entry) noexcept {
+        constexpr auto Enemies = ~Color;
+        constexpr auto Up      = Color == White ? North : South;
+        constexpr auto Back    = Color == White ? South : North;
+
+        const auto pawns   = Board[Pawns] & Board[Color];
+        const auto enemies = Board[Pawns] & Board[Enemies];
+        const auto Sides   = [](Bitboard set) {
+            return Utils::ShiftTo<East>(set) | Utils::ShiftTo<West>(set);
+        };
+        const auto Attacks = [&Sides](Bitboard set) {
+            return Sides(Color == White ? set << 8 : set >> 8);
+        };
+        const auto EnemyAttacks = [&Sides](Bitboard set) {
+            return Sides(Color == White ? set >> 8 : set << 8);
+        };
+
+        Entry.attacks[Color] = Attacks(pawns);
+        Entry.spans  [Color] = Fill<Up>(Entry.attacks[Color]);
+
+        const auto files     = Fill<North>(pawns) | Fill<South>(pawns);
+        const auto doubled   = pawns & Fill<Up>(Color == White ? pawns << 8 : pawns >> 8);
+        const auto isolated  = pawns & ~Sides(files);
+        const auto supported = Fill<Up>(Sides(pawns));
+        const auto stopped   = Color == White ? EnemyAttacks(enemies) >> 8 : EnemyAttacks(enemies) << 8;
+        const auto backward  = pawns & ~isolated & ~supported & stopped;
+
+        const auto front     = Fill<Back>(Color == White ? enemies >> 8 : enemies << 8);
+        const auto blocked   = Fill<Back>(Color == White ? pawns   >> 8 : pawns   << 8);
+        auto passed          = pawns & ~(front | Sides(front)) & ~blocked;
+
+        auto score = Doubled  * Utils::PopCount(doubled)
+                   + Isolated * Utils::PopCount(isolated)
+                   + Backward * Utils::PopCount(backward);
+        while (passed) {
+            const auto square = Utils::PopLS1B(passed);
+            score += Passed[Color == White ? square / 8 : 7 - square / 8];
+        } return score;
+    }
+
+    static inline thread_local std::array<PawnEntry, PAWN_HASH_ENTRIES> Table { };
+
+     PawnHash()=delete;
+    ~PawnHash()=delete;
+};
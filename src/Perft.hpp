@@ -5,52 +5,281 @@
 
 #include <chrono>
 #include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <deque>
+#include <vector>
+
+#define PERFT_HASH_MAX_MB 65536
+
+// Subtree counts keyed by position and depth. The key is stored xor'ed with the data so
+// that an entry torn by a concurrent writer simply fails to match.
+struct PerftEntry {
+    std::atomic<std::uint64_t> key;
+    std::atomic<std::uint64_t> data; // nodes:56 depth:8
+};
+
+// An independent subtree of a parallel perft, every worker plays it on its own copy.
+struct PerftTask {
+    GameState Board;
+    int       depth;
+};
 
 class Perft final {
 public:
     static std::uint64_t Run(GameState& Board, int depth) noexcept {
-        std::uint64_t nodes = 0;
-
         auto started  = std::chrono::steady_clock::now();
+        auto nodes    = Count(Board, depth);
+        auto finished = std::chrono::steady_clock::now();
+
+        auto sec = std::chrono::duration<float>(finished-started).count();
+        std::cout.imbue(std::locale(""));
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[depth=" << depth << "][" << nodes << "]["
+            << "" << std::setprecision(2) << nodes/sec/1000000 << "Mnps]\n";
+
+        return nodes;
+    }
+
+    // Node count below every root move, the usual way to pinpoint a generator bug.
+    static std::uint64_t Divide(GameState& Board, int depth) noexcept {
+        return Board.to_play == White ? Divide<White>(Board, depth)
+                                      : Divide<Black>(Board, depth);
+    }
+
+    // Splits the tree `split` plies below the root and counts the subtrees on a work-stealing
+    // pool: tasks are dealt round-robin, each thread drains its own queue from the back and
+    // steals from the front of the others once it runs dry. With `baseline` the serial count
+    // is timed first to report the speedup and scaling efficiency.
+    static std::uint64_t Parallel(GameState& Board, int depth, int threads, int split,
+                                  bool baseline=true) noexcept {
+        threads = std::clamp<int>(threads ? threads : std::thread::hardware_concurrency(), 1, 256);
+        split   = std::clamp<int>(split, 0, std::max(depth-1, 0));
+
+        auto serial = 0.0f; std::uint64_t expected = 0;
+        if (baseline) {
+            auto started  = std::chrono::steady_clock::now();
+            expected      = Count(Board, depth);
+            auto finished = std::chrono::steady_clock::now();
+            serial = std::chrono::duration<float>(finished-started).count();
+            Clear(); // both runs start from the same (cold) hash table
+        }
+
+        auto started = std::chrono::steady_clock::now();
+
+        std::vector<PerftTask> tasks;
+        if (Board.to_play == White) Split<White>(Board, split, depth, tasks);
+        else                        Split<Black>(Board, split, depth, tasks);
+
+        std::vector<std::deque<std::size_t>> queues(threads);
+        std::vector<std::mutex>              locks (threads);
+        for (std::size_t task = 0; task < tasks.size(); ++task)
+            queues[task % threads].push_back(task);
+
+        std::vector<std::uint64_t> nodes (threads), done(threads), stolen(threads);
+        const auto Worker = [&](int id) {
+            for (;;) {
+                std::size_t task = tasks.size();
+                {   std::lock_guard<std::mutex> lock(locks[id]);
+                    if (!queues[id].empty()) task = queues[id].back(), queues[id].pop_back();
+                }
+                for (auto victim = (id+1) % threads; task == tasks.size() && victim != id;
+                     victim = (victim+1) % threads) {
+                    std::lock_guard<std::mutex> lock(locks[victim]);
+                    if (!queues[victim].empty())
+                        task = queues[victim].front(), queues[victim].pop_front(), ++stolen[id];
+                }
+                if (task == tasks.size()) return;
+
+                GameState Local = tasks[task].Board;
+                nodes[id] += Count(Local, tasks[task].depth), ++done[id];
+            }
+        };
+
+        std::vector<std::thread> pool;
+        for (auto id = 1; id < threads; ++id) pool.emplace_back(Worker, id);
+        Worker(0);
+        for (auto& thread: pool) thread.join();
+
+        auto finished = std::chrono::steady_clock::now();
+        auto parallel = std::chrono::duration<float>(finished-started).count();
+
+        std::uint64_t total = 0;
+        std::cout << std::fixed << std::setprecision(2);
+        for (auto id = 0; id < threads; ++id) {
+            total += nodes[id];
+            std::cout << "[thread " << id << "][tasks=" << done[id] << "][stolen="
+                      << stolen[id] << "][" << nodes[id] << "]\n";
+        }
+        std::cout << "[depth=" << depth << "][split=" << split << "][tasks=" << tasks.size()
+                  << "][" << total << "][" << parallel*1000 << "ms]["
+                  << total/parallel/1000000 << "Mnps]\n";
+
+        if (baseline) {
+            const auto speedup = serial / parallel;
+            std::cout << "[serial][" << expected << "][" << serial*1000 << "ms][speedup="
+                      << speedup << "x][efficiency=" << 100*speedup/threads << "%]"
+                      << (expected == total ? "" : "[MISMATCH]") << "\n";
+        }
+        return total;
+    }
+
+    // Runs an EPD file of `<fen> ;D1 <nodes> ;D2 <nodes> ...` lines, up to `max_depth`,
+    // and reports every mismatch. Returns whether all of them passed.
+    static bool Suite(const std::string& path, int max_depth) noexcept {
+        std::ifstream file(path);
+        if (!file) { std::cout << "[suite][cannot open " << path << "]\n"; return false; }
+
+        std::uint64_t nodes = 0; int passed = 0, failed = 0, line_number = 0;
+        auto started = std::chrono::steady_clock::now();
+        for (std::string line; std::getline(file, line); ) { ++line_number;
+            if (line.empty() || line[0] == '#') continue;
+
+            // EPD carries the first four FEN fields only.
+            std::istringstream fields(line); std::string epd, field, fen;
+            std::getline(fields, epd, ';');
+            std::istringstream position(epd);
+            for (auto count = 0; count < 4 && position >> field; ++count) fen += field + " ";
+            fen += "0 1";
+
+            GameState Board;
+            try { Board = GameState(fen); } catch (const std::exception& error) {
+                std::cout << "[line " << line_number << "][" << error.what() << "]\n";
+                ++failed; continue;
+            }
+
+            while (std::getline(fields, field, ';')) {
+                std::istringstream tokens(field); std::string tag; std::uint64_t expected;
+                if (!(tokens >> tag >> expected) || tag.size() < 2 || tag[0] != 'D') continue;
+                const auto depth = std::atoi(tag.c_str()+1);
+                if (depth < 1 || depth > max_depth) continue;
+
+                const auto count = Count(Board, depth);
+                nodes += count;
+                if (count == expected) { ++passed; continue; }
+                ++failed;
+                std::cout << "[line " << line_number << "][depth=" << depth << "][expected "
+                          << expected << "][got " << count << "] " << fen << "\n";
+            }
+        }
+        auto finished = std::chrono::steady_clock::now();
 
-        if (depth % 2 == 0) nodes = (Board.to_play ==
+        auto sec = std::chrono::duration<float>(finished-started).count();
+        std::cout << std::fixed << std::setprecision(2);
+        std::cout << "[suite][" << passed << " passed][" << failed << " failed]["
+                  << nodes << "][" << nodes/sec/1000000 << "Mnps]\n";
+        return failed == 0;
+    }
+
+    // Enables the perft hash table, 0 turns it off again.
+    static void Hash(std::size_t mb) noexcept {
+        mb = std::min<std::size_t>(mb, PERFT_HASH_MAX_MB);
+        entries = (mb << 20) / sizeof(PerftEntry);
+        table.reset(entries ? new PerftEntry[entries] : nullptr);
+        Clear();
+    }
+
+private:
+    static inline std::unique_ptr<PerftEntry[]> table;
+    static inline std::size_t                   entries = 0;
+
+    static void Clear() noexcept {
+        for (std::size_t index = 0; index < entries; ++index)
+            table[index].key = 0, table[index].data = 0;
+    }
+
+    static std::uint64_t Count(GameState& Board, int depth) noexcept {
+        if (depth % 2 == 0) return (Board.to_play ==
             White ? EvenPerft<White>(Board, depth) :
                     EvenPerft<Black>(Board, depth));
-
-        if (depth % 2 != 0) nodes = (Board.to_play ==
+        else return (Board.to_play ==
             White ? OddPerft<White>(Board, depth) :
                     OddPerft<Black>(Board, depth));
+    }
+
+    template <EnumColor Color>
+    static std::uint64_t Divide(GameState& Board, int depth) noexcept {
+        auto [move_list, nmoves] = MoveGeneration::Legal<Color>(Board);
 
+        auto started = std::chrono::steady_clock::now();
+        STATE_SAVE(Board); UndoState Undo;
+        std::uint64_t nodes = 0;
+        for (auto move = 0; move < nmoves; move++) {
+            (void)Move::Make<Color, false>(Board, move_list[move], Undo);
+            const auto count = depth > 1 ? Count(Board, depth-1) : 1ULL;
+            STATE_RESTORE(Color, Board, move_list[move], Undo);
+            std::cout << move_list[move] << ": " << count << "\n";
+            nodes += count;
+        }
         auto finished = std::chrono::steady_clock::now();
-        auto ms = std::chrono::duration_cast
-                    <std::chrono::milliseconds>
-                    (finished-started).count();
 
-        auto sec = ms / 1000.00000f;
-        std::cout.imbue(std::locale(""));
+        auto sec = std::chrono::duration<float>(finished-started).count();
         std::cout << std::fixed << std::setprecision(2);
-        std::cout << "[depth=" << depth << "][" << nodes << "]["
-            << "" << std::setprecision(2) << nodes/sec/1000000 << "Mnps]\n";
-
+        std::cout << "\n[moves=" << nmoves << "][depth=" << depth << "][" << nodes << "]["
+                  << nodes/sec/1000000 << "Mnps]\n";
         return nodes;
     }
 
-private:
+    template <EnumColor Color>
+    static void Split(GameState& Board, int plies, int depth, std::vector<PerftTask>& tasks) noexcept {
+        if (plies == 0) return tasks.push_back(PerftTask { Board, depth });
+
+        auto [move_list, nmoves] = MoveGeneration::Legal<Color>(Board);
+        STATE_SAVE(Board); UndoState Undo;
+        for (auto move = 0; move < nmoves; move++) {
+            (void)Move::Make<Color, false>(Board, move_list[move], Undo);
+            Split<~Color>(Board, plies-1, depth-1, tasks);
+            STATE_RESTORE(Color, Board, move_list[move], Undo);
+        }
+    }
+
+    [[nodiscard]] static inline PerftEntry& GetEntry(std::uint64_t hash, int depth) noexcept {
+        const auto key = hash ^ (0x9E3779B97F4A7C15ULL * depth);
+        return table[(static_cast<unsigned __int128>(key) * entries) >> 64];
+    }
+
+    [[nodiscard]] static inline bool Probe(GameState& Board, int depth, std::uint64_t& nodes) noexcept {
+        auto& entry = GetEntry(Board.hash, depth);
+        const auto data = entry.data.load(std::memory_order_relaxed);
+        const auto key  = entry.key .load(std::memory_order_relaxed);
+        if ((key ^ data) != Board.hash || int(data & 0xFF) != depth) return false;
+        nodes = data >> 8;
+        return true;
+    }
+
+    static inline void Store(GameState& Board, int depth, std::uint64_t nodes) noexcept {
+        auto& entry = GetEntry(Board.hash, depth);
+        const auto data = nodes << 8 | std::uint64_t(depth);
+        entry.key .store(Board.hash ^ data, std::memory_order_relaxed);
+        entry.data.store(data,              std::memory_order_relaxed);
+    }
 
     template <EnumColor Color> __attribute__((always_inline))
     static inline std::uint64_t EvenPerft(GameState& Board, int depth) noexcept {
         constexpr auto Other = ~Color;
         if (depth == 0) return 1ULL;
 
-        auto [move_list, nmoves] = MoveGeneration::Run<Color>(Board);
-
-        GameState Old = Board;
         std::uint64_t nodes = 0;
+        if (depth > 1 && entries && Probe(Board, depth, nodes)) return nodes;
+
+        // Every generated move is legal, so the last ply is counted without playing it.
+        auto [move_list, nmoves] = MoveGeneration::Legal<Color>(Board);
+        if (depth == 1) return nmoves;
+
+        STATE_SAVE(Board); UndoState Undo;
         for (auto move = 0; move < nmoves; move++) {
-            if (Move::Make<Color>(Board, move_list[move]))
-                nodes += OddPerft<Other>(Board, depth-1);
-            Board = Old;
-        } return nodes;
+            (void)Move::Make<Color, false>(Board, move_list[move], Undo);
+            nodes += OddPerft<Other>(Board, depth-1);
+            STATE_RESTORE(Color, Board, move_list[move], Undo);
+        }
+
+        if (entries) Store(Board, depth, nodes);
+        return nodes;
     }
 
     template <EnumColor Color> __attribute__((noinline))
@@ -58,15 +287,22 @@ private:
         constexpr auto Other = ~Color;
         if (depth == 0) return 1ULL;
 
-        auto [move_list, nmoves] = MoveGeneration::Run<Color>(Board);
-
-        GameState Old = Board;
         std::uint64_t nodes = 0;
+        if (depth > 1 && entries && Probe(Board, depth, nodes)) return nodes;
+
+        // Every generated move is legal, so the last ply is counted without playing it.
+        auto [move_list, nmoves] = MoveGeneration::Legal<Color>(Board);
+        if (depth == 1) return nmoves;
+
+        STATE_SAVE(Board); UndoState Undo;
         for (auto move = 0; move < nmoves; move++) {
-            if (Move::Make<Color>(Board, move_list[move]))
-                nodes += EvenPerft<Other>(Board, depth-1);
-            Board = Old;
-        } return nodes;
+            (void)Move::Make<Color, false>(Board, move_list[move], Undo);
+            nodes += EvenPerft<Other>(Board, depth-1);
+            STATE_RESTORE(Color, Board, move_list[move], Undo);
+        }
+
+        if (entries) Store(Board, depth, nodes);
+        return nodes;
     }
 
      Perft()=delete;
@@ -0,0 +1,226 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+#include "GameState.hpp"
+#include "Utils.hpp"
+
+#include <array>
+#include <algorithm>
+
+// Midgame and endgame halves packed in one integer, the endgame in the upper 16 bits:
+// material and piece-square terms are then added and subtracted for both phases at once.
+using Score = std::int32_t;
+
+[[nodiscard]] constexpr inline Score S(int mg, int eg) noexcept {
+    return Score(std::uint32_t(eg) << 16) + mg;
+}
+
+[[nodiscard]] constexpr inline int MgScore(Score score) noexcept {
+    return std::int16_t(std::uint16_t(std::uint32_t(score)));
+}
+
+[[nodiscard]] constexpr inline int EgScore(Score score) noexcept {
+    return std::int16_t(std::uint16_t(std::uint32_t(score + 0x8000) >> 16));
+}
+
+// Tables are laid out from White's side, a1 first. Black reads them mirrored.
+constexpr inline std::array<std::array<int, 64>, 6> PieceSquareMg {
+    {
+    { // PAWNS
+        0,   0,   0,   0,   0,   0,   0,   0,
+        0,   0,   0, -10, -10,   0,   0,   0,
+        0,   0,   0,   5,   5,   0,   0,   0,
+        5,   5,  10,  20,  20,   5,   5,   5,
+        10,  10,  10,  20,  20,  10,  10,  10,
+        20,  20,  20,  30,  30,  30,  20,  20,
+        30,  30,  30,  40,  40,  30,  30,  30,
+        90,  90,  90,  90,  90,  90,  90,  90,
+    },
+
+    { // KNIGHTS
+        -5, -10,   0,   0,   0,   0, -10,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+        -5,   5,  20,  10,  10,  20,   5,  -5,
+        -5,  10,  20,  30,  30,  20,  10,  -5,
+        -5,  10,  20,  30,  30,  20,  10,  -5,
+        -5,   5,  20,  20,  20,  20,   5,  -5,
+        -5,   0,   0,  10,  10,   0,   0,  -5,
+        -5,   0,   0,   0,   0,   0,   0,  -5,
+    },
+
+    { // BISHOPS
+        0,   0, -10,   0,   0, -10,   0,   0,
+        0,  30,   0,   0,   0,   0,  30,   0,
+        0,  10,   0,   0,   0,   0,  10,   0,
+        0,   0,  10,  20,  20,  10,   0,   0,
+        0,   0,  10,  20,  20,  10,   0,   0,
+        0,   0,   0,  10,  10,   0,   0,   0,
+        0,   0,   0,   0,   0,   0,   0,   0,
+        0,   0,   0,   0,   0,   0,   0,   0,
+    },
+
+    { // ROOKS
+        0,   0,   0,  20,  20,   0,   0,   0,
+        0,   0,  10,  20,  20,  10,   0,   0,
+        0,   0,  10,  20,  20,  10,   0,   0,
+        0,   0,  10,  20,  20,  10,   0,   0,
+        0,   0,  10,  20,  20,  10,   0,   0,
+        0,   0,  10,  20,  20,  10,   0,   0,
+        50,  50,  50,  50,  50,  50,  50,  50,
+        50,  50,  50,  50,  50,  50,  50,  50,
+    },
+
+    { // QUEENS
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+        -10,   0,   5,   0,   0,   0,   0, -10,
+        -10,   5,   5,   5,   5,   5,   0, -10,
+          0,   0,   5,   5,   5,   5,   0,  -5,
+         -5,   0,   5,   5,   5,   5,   0,  -5,
+        -10,   0,   5,   5,   5,   5,   0, -10,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -20, -10, -10,  -5,  -5, -10, -10, -20,
+    },
+
+    { // KING
+        0,   0,   5,   0, -15,   0,  10,   0,
+        0,   5,   5,  -5,  -5,   0,   5,   0,
+        0,   0,   5,  10,  10,   5,   0,   0,
+        0,   5,  10,  20,  20,  10,   5,   0,
+        0,   5,  10,  20,  20,  10,   5,   0,
+        0,   5,   5,  10,  10,   5,   5,   0,
+        0,   0,   5,   5,   5,   5,   0,   0,
+        0,   0,   0,   0,   0,   0,   0,   0,
+    }
+    }
+};
+
+constexpr inline std::array<std::array<int, 64>, 6> PieceSquareEg {
+    {
+    { // PAWNS
+        0,   0,   0,   0,   0,   0,   0,   0,
+        5,   5,   5,   5,   5,   5,   5,   5,
+        10,  10,  10,  10,  10,  10,  10,  10,
+        20,  20,  20,  20,  20,  20,  20,  20,
+        35,  35,  35,  35,  35,  35,  35,  35,
+        60,  60,  60,  60,  60,  60,  60,  60,
+        100, 100, 100, 100, 100, 100, 100, 100,
+        0,   0,   0,   0,   0,   0,   0,   0,
+    },
+
+    { // KNIGHTS
+        -30, -20, -10, -10, -10, -10, -20, -30,
+        -20, -10,   0,   0,   0,   0, -10, -20,
+        -10,   0,  10,  15,  15,  10,   0, -10,
+        -10,   5,  15,  20,  20,  15,   5, -10,
+        -10,   5,  15,  20,  20,  15,   5, -10,
+        -10,   0,  10,  15,  15,  10,   0, -10,
+        -20, -10,   0,   0,   0,   0, -10, -20,
+        -30, -20, -10, -10, -10, -10, -20, -30,
+    },
+
+    { // BISHOPS
+        -15, -10, -10,  -5,  -5, -10, -10, -15,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+         -5,   0,  10,  15,  15,  10,   0,  -5,
+         -5,   0,  10,  15,  15,  10,   0,  -5,
+        -10,   0,   5,  10,  10,   5,   0, -10,
+        -10,   0,   0,   0,   0,   0,   0, -10,
+        -15, -10, -10,  -5,  -5, -10, -10, -15,
+    },
+
+    { // ROOKS
+        0,   0,   0,   0,   0,   0,   0,   0,
+        0,   0,   0,   0,   0,   0,   0,   0,
+        0,   0,   0,   0,   0,   0,   0,   0,
+        0,   0,   0,   0,   0,   0,   0,   0,
+        5,   5,   5,   5,   5,   5,   5,   5,
+        5,   5,   5,   5,   5,   5,   5,   5,
+        20,  20,  20,  20,  20,  20,  20,  20,
+        10,  10,  10,  10,  10,  10,  10,  10,
+    },
+
+    { // QUEENS
+        -30, -20, -10, -10, -10, -10, -20, -30,
+        -20, -10,   0,   5,   5,   0, -10, -20,
+        -10,   0,  15,  20,  20,  15,   0, -10,
+        -10,   5,  20,  30,  30,  20,   5, -10,
+        -10,   5,  20,  30,  30,  20,   5, -10,
+        -10,   0,  15,  20,  20,  15,   0, -10,
+        -20, -10,   0,   5,   5,   0, -10, -20,
+        -30, -20, -10, -10, -10, -10, -20, -30,
+    },
+
+    { // KING
+        -50, -30, -20, -20, -20, -20, -30, -50,
+        -30, -10,   0,   0,   0,   0, -10, -30,
+        -20,   0,  20,  25,  25,  20,   0, -20,
+        -20,   0,  25,  35,  35,  25,   0, -20,
+        -20,   0,  25,  35,  35,  25,   0, -20,
+        -20,   0,  20,  25,  25,  20,   0, -20,
+        -30, -10,   0,   0,   0,   0, -10, -30,
+        -50, -30, -20, -20, -20, -20, -30, -50,
+    }
+    }
+};
+
+// Material plus piece-square bonus of every [color][piece][square], signed from White's
+// point of view so that both sides accumulate into the same score.
+class PieceSquare final {
+public:
+    static constexpr Score PieceScore[6] {
+        S(100, 120), S(300, 290), S(300, 310), S(500, 530), S(900, 940), S(0, 0)
+    };
+
+    // Game phase: 24 with every minor and major piece on the board, 0 with pawns and kings.
+    static constexpr int PhaseWeight[6] { 0, 1, 1, 2, 4, 0 };
+    static constexpr int PhaseMax = 24;
+
+    static constexpr auto Table = [] {
+        std::array<std::array<std::array<Score, 64>, 6>, 2> table { };
+        for (auto piece = 0; piece < 6; ++piece)
+            for (EnumSquare square = a1; square <= h8; ++square) {
+                const auto mirror = EnumSquare(int(square) ^ 56);
+                table[White][piece][square] = PieceScore[piece]
+                    + S(PieceSquareMg[piece][square], PieceSquareEg[piece][square]);
+                table[Black][piece][square] =-PieceScore[piece]
+                    - S(PieceSquareMg[piece][mirror], PieceSquareEg[piece][mirror]);
+            }
+        return table;
+    }();
+
+    [[nodiscard]] static constexpr inline auto Get(EnumColor color, EnumPiece piece, EnumSquare square) noexcept {
+        return Table[color][piece-2][square];
+    }
+
+    [[nodiscard]] static constexpr inline auto Phase(EnumPiece piece) noexcept {
+        return PhaseWeight[piece-2];
+    }
+
+    // Full recomputation, used to seed GameState and to cross-check the running score.
+    [[nodiscard]] static inline Score Accumulate(const GameState& Board) noexcept {
+        Score score = 0;
+        for (int piece = Pawns; piece <= King; ++piece) {
+            auto WhitePieces = Board[piece] & Board[White];
+            auto BlackPieces = Board[piece] & Board[Black];
+            while (WhitePieces) score += Get(White, EnumPiece(piece), Utils::PopLS1B(WhitePieces));
+            while (BlackPieces) score += Get(Black, EnumPiece(piece), Utils::PopLS1B(BlackPieces));
+        } return score;
+    }
+
+    [[nodiscard]] static inline int GamePhase(const GameState& Board) noexcept {
+        auto phase = 0;
+        for (int piece = Pawns; piece <= King; ++piece)
+            phase += Phase(EnumPiece(piece)) * Utils::PopCount(Board[piece]);
+        return phase;
+    }
+
+    // Interpolates between the midgame and endgame halves, White's point of view.
+    [[nodiscard]] static constexpr inline int Taper(Score score, int phase) noexcept {
+        phase = std::min(phase, PhaseMax);
+        return (MgScore(score) * phase + EgScore(score) * (PhaseMax - phase)) / PhaseMax;
+    }
+
+     PieceSquare()=delete;
+    ~PieceSquare()=delete;
+};
@@ -4,8 +4,11 @@
 #include "TranspositionTable.hpp"
 #include "MoveGeneration.hpp"
 #include "MoveOrdering.hpp"
+#include "MovePicker.hpp"
+#include "NodeAttacks.hpp"
 #include "ChessEngine.hpp"
 #include "Evalutation.hpp"
+#include "TimeManager.hpp"
 
 #include <algorithm>
 #include <cstring>
@@ -15,33 +18,79 @@
 #define STALEMATE  00000
 #define INF        50000
 
-static TranspositionTable HashTable;
+#define MAX_DEPTH  63
+#define NODES_FLUSH 1024
+
+#define ASPIRATION_DEPTH  4  // first iteration searched with a window around the last score
+#define ASPIRATION_WINDOW 40 // half width of that window, in centipawns
+
+inline TranspositionTable HashTable;
 
 class Search final { friend class UCI;
 public:
-    static inline std::uint64_t nodes;
-    static inline std::uint8_t  ply;
+    // Per-thread search state, every Lazy SMP worker owns its own copy.
+    static inline thread_local std::uint64_t nodes;
+    static inline thread_local std::uint8_t  ply;
 
-    static inline auto Init() noexcept {
-        // HashTable.Clear();
+    static inline auto Reset() noexcept {
         std::memset(&PrincipalVariation::table,  0, sizeof(PrincipalVariation::table));
         std::memset(&PrincipalVariation::length, 0, sizeof(PrincipalVariation::length));
+        std::memset(&MoveOrdering::killers,      0, sizeof(MoveOrdering::killers));
+        std::memset(&MoveOrdering::countermoves, 0, sizeof(MoveOrdering::countermoves));
+        std::memset(&MoveOrdering::history,      0, sizeof(MoveOrdering::history));
         Search::nodes = 0, Search::ply = 0;
     }
 
+    static inline auto Init() noexcept {
+        // HashTable.Clear();
+        Search::total_nodes = 0;
+        Search::Reset();
+        EvalCache::ResetStatistics();
+        MoveOrdering::ResetStatistics();
+        NodeStatistics::ResetStatistics();
+    }
+
     [[nodiscard]] static auto AlphaBetaNegamax
-    (GameState& Board, int depth) noexcept {
+    (GameState& Board, int depth, int alpha = -INF, int beta = INF) noexcept {
         return Board.to_play == White ?
-            Negamax<White>(Board, -INF, INF, depth) :
-            Negamax<Black>(Board, -INF, INF, depth) ;
+            Negamax<White>(Board, alpha, beta, depth) :
+            Negamax<Black>(Board, alpha, beta, depth) ;
+    }
+
+    static inline auto Flush() noexcept {
+        total_nodes.fetch_add(nodes % NODES_FLUSH, std::memory_order_relaxed);
+        nodes -= nodes % NODES_FLUSH;
+    }
+
+    // Lazy SMP helper: searches its own copy of the root with the shared HashTable
+    // until the main thread raises `stop`. Odd helpers run one ply ahead so that the
+    // threads desynchronize and fill the table with entries the others can reuse.
+    static inline auto Helper(GameState Board, int id) noexcept {
+        Search::Reset();
+        for (int depth = 1 + (id & 1); depth <= MAX_DEPTH && !stop; ++depth)
+            (void)Search::AlphaBetaNegamax(Board, depth);
+        Search::Flush(); EvalCache::Flush(); MoveOrdering::Flush(); NodeStatistics::Flush();
+    }
+
+    // Nodes searched by every thread, exact up to NODES_FLUSH per running helper.
+    [[nodiscard]] static inline std::uint64_t TotalNodes() noexcept {
+        return total_nodes.load(std::memory_order_relaxed) + nodes % NODES_FLUSH;
     }
 
 private:
-    static inline std::atomic<bool> stop = false;
+    static inline std::atomic<bool>          stop        = false;
+    static inline std::atomic<std::uint64_t> total_nodes = 0;
+
+    static inline auto CountNode() noexcept {
+        if (++Search::nodes % NODES_FLUSH == 0) {
+            const auto total = total_nodes.fetch_add(NODES_FLUSH, std::memory_order_relaxed);
+            if (TimeManager::HardStop(total + NODES_FLUSH)) stop = true;
+        }
+    }
 
     template <EnumColor Color> [[nodiscard]]
     static inline int Negamax(GameState& Board, int alpha, int beta, int depth) noexcept {
-        constexpr auto Other = ~Color; ++Search::nodes; auto score = 0;
+        constexpr auto Other = ~Color; Search::CountNode(); auto score = 0;
 
         if (stop) return beta;
 
@@ -49,29 +98,29 @@ private:
 
         PrincipalVariation::UpdateLength(Search::ply);
 
-        if (depth == 0) return Evaluation::Run<Color>(Board);
-        // if (depth == 0) return Search::Quiescence<Color>(Board, alpha, beta);
+        if (depth == 0) return Search::Quiescence<Color>(Board, alpha, beta);
 
         TTFlag HashFlag = HashAlpha;
-        if (Search::ply && (score = HashTable.Probe(Board, alpha, beta, depth) != 0xDEAD))
-            return beta; // THE FUCK IS GOING ON HERE?!
-
-        if (NullMovePruning<Other>(Board, beta, depth) >= beta)
-            return beta;
-
-        auto [move_list, nmoves] = MoveGeneration::Run<Color>(Board);
+        Move hash_move;
+        score = HashTable.Probe(Board, alpha, beta, depth, Search::ply, hash_move);
+        if (Search::ply && score != 0xDEAD) return score;
 
+        NodeAttacks<Color> Node(Board);
 
-        // DO NOT TOUCH THE +1 OR -1 IN FUNCTION, CURSED COMPILER OPTIMIZATIONS
-        // MoveOrdering::SwapFirst(Board, move_list, nmoves, Search::ply+1);
-        MoveOrdering::SortAll(Board, move_list, nmoves, Search::ply+1);
+        if (NullMovePruning<Other>(Board, Node, beta, depth) >= beta)
+            return beta;
 
+        MovePicker<Color> Picker(Board, Node, hash_move, Search::ply);
 
-        GameState Old = Board; Move best_move; auto legal_moves = 0;
-        for (auto move_index = 0; move_index < nmoves; move_index++) {
-            auto move = move_list[move_index];
-            if (Move::Make<Color>(Board, move)) { ++legal_moves;
+        STATE_SAVE(Board); UndoState Undo; Move best_move { }; auto legal_moves = 0;
+        std::array<Move, 64> quiets; auto nquiets = 0; // searched without a cutoff
+        for (Move move; (move = Picker.Next()).piece; ) {
+            const auto legal = Node.Safe(move) ? Move::Make<Color, false>(Board, move, Undo)
+                                               : Move::Make<Color>(Board, move, Undo);
+            const auto quiet = !(move.flags & (Capture|PromotionKnight));
+            if (legal) { ++legal_moves;
 
+                MoveOrdering::SetPlayed(move, Search::ply);
                 ++Search::ply;
                 if (PrincipalVariationSearch) {
                     score = -Negamax<Other>(Board, -alpha-1, -alpha, depth-1);
@@ -80,73 +129,113 @@ private:
                 } else  score = -Negamax<Other>(Board, -beta, -alpha, depth-1);
                 --Search::ply;
 
-                if (score > alpha) { PrincipalVariationSearch = true;
-                    if (score >= beta) {
-                        HashTable.Record(Old, HashBeta, score, move, depth);
-                        return beta;
+            } STATE_RESTORE(Color, Board, move, Undo);
+
+            if (legal && score > alpha) { PrincipalVariationSearch = true;
+                if (score >= beta) {
+                    ++MoveOrdering::cutoffs, MoveOrdering::first_cutoffs += legal_moves == 1;
+                    // A stopped child returns a bound of its own window, not a real score.
+                    if (!stop) {
+                        if (quiet)
+                            MoveOrdering::UpdateQuiets(Color, move, quiets.data(), nquiets, depth, Search::ply);
+                        HashTable.Record(Board, HashBeta, score, move, depth, Search::ply);
                     }
-                    alpha = score, best_move = move;
-                    PrincipalVariation::UpdateTable(Search::ply, best_move);
-                    HashFlag = HashExact;
+                    // A root fail high is the move to play if the re-search runs out of time,
+                    // unless the search stopped inside it and it never really failed high.
+                    if (!Search::ply && !stop) PrincipalVariation::UpdateTable(Search::ply, move);
+                    return beta;
                 }
-            } Board = Old;
+                alpha = score, best_move = move;
+                PrincipalVariation::UpdateTable(Search::ply, best_move);
+                HashFlag = HashExact;
+            }
+            if (legal && quiet && nquiets < int(quiets.size())) quiets[nquiets++] = move;
         }
 
         if (!legal_moves) {
-            if (GameState::InCheck<Color>(Board, Utils::IndexLS1B(Board[King] & Board[Color])))
+            if (Node.InCheck())
                 return -CHECKMATE + Search::ply+1;
             else return STALEMATE;
         }
 
-        HashTable.Record(Board, HashFlag, alpha, best_move, depth);
+        // An interrupted node has not seen all of its moves, its bound means nothing: answer
+        // with beta like a node entered after the stop, which the parent reads as its alpha.
+        if (stop) return beta;
+
+        HashTable.Record(Board, HashFlag, alpha, best_move, depth, Search::ply);
         return alpha;
     }
 
     template <EnumColor Other> [[nodiscard]]
-    static inline int NullMovePruning(GameState& Board, int beta, int depth) noexcept {
+    static inline int NullMovePruning(GameState& Board, NodeAttacks<~Other>& Node, int beta, int depth) noexcept {
         constexpr auto R = 3;
-        if (depth >= R+1 && ply) {
-            GameState Old = Board;
+        // Passing while in check would let the opponent take the king.
+        if (depth >= R+1 && ply && !Node.InCheck()) {
+            const auto hash = Board.hash; const auto en_passant = Board.en_passant;
             if (Board.en_passant)
                 Board.hash ^= ZobristHashing::Keys.EnPassant[Board.en_passant];
             Board.hash ^= ZobristHashing::Keys.Side;
             Board.to_play = Other;
             Board.en_passant = EnumSquare(0);
+            MoveOrdering::SetPlayed(Move { }, Search::ply);
             ++Search::ply;
             auto score = -Negamax<Other>(Board, -beta, -beta + 1, depth-1 - R);
             --Search::ply;
-            Board = Old; return score;
+            Board.to_play = ~Other, Board.hash = hash, Board.en_passant = en_passant;
+            return score;
         } else return -INF;
     }
 
     template <EnumColor Color> [[nodiscard]]
     static inline int Quiescence(GameState& Board, int alpha, int beta) noexcept {
-        constexpr auto Other = ~Color; ++Search::nodes;
+        constexpr auto Other = ~Color; Search::CountNode();
 
-        int score = Evaluation::Run<Color>(Board);
+        if (stop) return beta;
 
-        if (score >= beta) return beta;
-        if (score > alpha) alpha = score;
+        // The per-ply move ordering tables end at MAX_DEPTH, a capture sequence that long
+        // is only ever a race of checks: take the static score and stop there.
+        if (Search::ply >= MAX_DEPTH) return Evaluation::Run<Color>(Board);
 
-        auto [move_list, nmoves] = MoveGeneration::Run<Color>(Board);
+        // In check there is no standing pat: every evasion is searched, and having none
+        // is a mate. Otherwise only captures and promotions are.
+        NodeAttacks<Color> Node(Board);
+        const auto in_check = Node.InCheck();
 
-        MoveOrdering::SortAll(Board, move_list, nmoves, Search::ply+1);
+        if (!in_check) {
+            int score = Evaluation::Run<Color>(Board);
 
-        GameState Old = Board;
+            if (score >= beta) return beta;
+            if (score > alpha) alpha = score;
+        }
+
+        MoveList move_list; auto iterator = move_list.begin();
+        if (in_check) MoveGeneration::Generate<Color, GenEvasions>(Board, iterator, Node);
+        else          MoveGeneration::Generate<Color, GenCaptures>(Board, iterator, Node);
+        const auto nmoves = int(std::distance(move_list.begin(), iterator));
+
+        MoveScores scores; MoveOrdering::ScoreAll(Board, move_list, scores, 0, nmoves, Search::ply);
+
+        STATE_SAVE(Board); UndoState Undo; auto legal_moves = 0;
 
         for (auto move_index = 0; move_index < nmoves; move_index++) {
-            auto current_move = move_list[move_index];
-            if (current_move.flags & Capture) {
-                if (Move::Make<Color>(Board, current_move)) {
-                    auto score = -Quiescence<Other>(Board, -beta, -alpha);
-                    if (score > alpha) {
-                        if (score >= beta) return beta;
-                        alpha = score;
-                    }
+            auto current_move = MoveOrdering::PickBest(move_list, scores, move_index, nmoves);
+            const auto legal = Node.Safe(current_move) ? Move::Make<Color, false>(Board, current_move, Undo)
+                                                       : Move::Make<Color>(Board, current_move, Undo);
+            if (legal) { ++legal_moves;
+                ++Search::ply;
+                auto score = -Quiescence<Other>(Board, -beta, -alpha);
+                --Search::ply;
+                STATE_RESTORE(Color, Board, current_move, Undo);
+                if (score > alpha) {
+                    if (score >= beta) return beta;
+                    alpha = score;
                 }
-            } Board = Old;
+            } else STATE_RESTORE(Color, Board, current_move, Undo);
         }
 
+        if (in_check && !legal_moves)
+            return -CHECKMATE + Search::ply+1;
+
         return alpha;
     }
 
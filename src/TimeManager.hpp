@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ChessEngine.hpp"
+#include "Move.hpp"
+
+#include <chrono>
+#include <atomic>
+#include <cstdint>
+#include <algorithm>
+
+#define MOVE_OVERHEAD    30 // ms kept back for the GUI and the network on every move
+#define MOVES_TO_GO      40 // assumed when the clock has no movestogo
+
+// Everything `go` can ask for, times in milliseconds.
+struct SearchLimits {
+    int           depth     = 0;
+    int           movetime  = 0;
+    std::uint64_t nodes     = 0;
+    int           time[2]   { };
+    int           inc [2]   { };
+    int           movestogo = 0;
+    bool          infinite  = false;
+    bool          ponder    = false;
+};
+
+// Two budgets per move. The hard limit is enforced from inside the search every
+// NODES_FLUSH nodes and is never more than a fraction of what is left on the clock. The
+// soft limit is only looked at between iterations: no new depth is started past it, and
+// it stretches when the best move keeps changing or the score drops. While pondering
+// neither applies; `ponderhit` starts the clock and the same search carries on.
+class TimeManager final {
+public:
+    static inline int overhead = MOVE_OVERHEAD;
+
+    static inline void Start(const SearchLimits& Limits, EnumColor color) noexcept {
+        started   = std::chrono::steady_clock::now();
+        armed     = false;
+        pondering = Limits.ponder;
+        ponder_hit_at = 0;
+        nodes     = Limits.nodes;
+        stability = 0, previous = 0, has_previous = false;
+        soft = hard = -1;
+
+        if (Limits.infinite) return;
+
+        if (Limits.movetime) {
+            hard = std::max(1, Limits.movetime - overhead);
+        } else if (Limits.time[color]) {
+            const auto available = std::max(1, Limits.time[color] - overhead);
+            const auto moves     = Limits.movestogo ? std::clamp(Limits.movestogo, 1, 50) : MOVES_TO_GO;
+            const auto target    = available / moves + Limits.inc[color] * 3 / 4;
+            hard = std::min(target * 4, available * (moves == 1 ? 9 : 4) / 10);
+            soft = std::min(target, hard);
+            hard = std::max(1, hard), soft = std::max(1, soft);
+        }
+    }
+
+    [[nodiscard]] static inline std::int64_t Elapsed() noexcept {
+        return std::chrono::duration_cast<std::chrono::milliseconds>
+              (std::chrono::steady_clock::now() - started).count();
+    }
+
+    // Time charged to our own clock: everything since `go`, or since `ponderhit`.
+    [[nodiscard]] static inline std::int64_t Used() noexcept {
+        return Elapsed() - ponder_hit_at;
+    }
+
+    // Limits only apply once the first iteration is done, so there is always a move to play.
+    static inline void Arm() noexcept { armed = true; }
+
+    static inline void PonderHit() noexcept {
+        ponder_hit_at = Elapsed();
+        pondering     = false;
+    }
+
+    [[nodiscard]] static inline bool Pondering() noexcept { return pondering; }
+
+    // Cheap enough for every NODES_FLUSH nodes: one clock read at most.
+    [[nodiscard]] static inline bool HardStop(std::uint64_t searched) noexcept {
+        return armed && !pondering
+            && ((nodes && searched >= nodes) || (hard >= 0 && Used() >= hard));
+    }
+
+    // After each completed iteration: whether the next one is worth starting. An iteration
+    // usually costs more than all the previous ones together, so half the budget must be left.
+    [[nodiscard]] static inline bool SoftStop(Move best_move, int score) noexcept {
+        stability = (has_previous && best_move == previous_move) ? stability + 1 : 0;
+        const auto drop = has_previous ? previous - score : 0;
+        previous = score, previous_move = best_move, has_previous = true;
+        if (soft < 0 || pondering) return false;
+
+        auto scale = stability == 0 ? 150 : stability >= 4 ? 70 : 100;
+        if (drop > 30) scale += drop > 80 ? 60 : 30;
+
+        const auto budget = std::min<std::int64_t>(std::int64_t(soft) * scale / 100, hard);
+        return Used() * 2 >= budget;
+    }
+
+private:
+    static inline std::chrono::steady_clock::time_point started;
+    static inline std::atomic<bool>                     armed = false;
+    static inline std::atomic<bool>                     pondering = false;
+    static inline std::atomic<std::int64_t>             ponder_hit_at = 0;
+
+    static inline std::uint64_t nodes = 0;
+    static inline int soft = -1, hard = -1; // -1: no limit
+
+    static inline int           stability     = 0;
+    static inline int           previous      = 0;
+    static inline Move          previous_move { };
+    static inline bool          has_previous  = false;
+
+     TimeManager()=delete;
+    ~TimeManager()=delete;
+};
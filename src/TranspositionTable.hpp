@@ -8,8 +8,15 @@
 #include <iostream>
 #include <random>
 #include <cstring>
+#include <atomic>
+#include <memory>
+#include <limits>
+#include <algorithm>
 
-#define HASH_TABLE_SIZE 0x100000 * 64 // 32mb
+#define HASH_TABLE_MB      32
+#define HASH_TABLE_MAX_MB  65536
+#define HASH_BUCKET_SIZE   8
+#define HASH_MATE_BOUND    10000 // scores past this are mate distances, see Record
 
 enum TTFlag {
     HashExact,
@@ -18,50 +25,143 @@ enum TTFlag {
     // HashUnknown = 0xDEAD,
 };
 
+// Every entry is packed in a single 64-bit word so that it is always written and read
+// in one go: concurrent searchers can share the table without locks and can never see
+// a torn entry, only (rarely) a stale one or a 16-bit key collision.
+//
+//  63      58 57  56 55       48 47           32 31           16 15            0
+// ┌──────────┬──────┬───────────┬───────────────┬───────────────┬───────────────┐
+// │generation│ flag │   depth   │     score     │     move      │      key      │
+// └──────────┴──────┴───────────┴───────────────┴───────────────┴───────────────┘
+//                                                 target:6 origin:6 flags:4
+
 struct TTData {
-    std::uint64_t hash;
-    std::uint32_t flag;
-    Move          move; // 1 byte
-    std::int32_t  score;
-    std::uint8_t  depth;
+    std::uint64_t data;
+
+    [[nodiscard]] constexpr inline std::uint16_t Key()   const noexcept { return data;       }
+    [[nodiscard]] constexpr inline std::int16_t  Score() const noexcept { return data >> 32; }
+    [[nodiscard]] constexpr inline std::uint8_t  Depth() const noexcept { return data >> 48; }
+    [[nodiscard]] constexpr inline int           Flag()  const noexcept { return (data >> 56) & 0x3;  }
+    [[nodiscard]] constexpr inline int           Gen()   const noexcept { return (data >> 58) & 0x3F; }
+
+    [[nodiscard]] static constexpr inline auto Pack
+    (std::uint16_t key, Move move, int score, int depth, int flag, int gen) noexcept {
+        score = std::clamp<int>(score, -std::numeric_limits<std::int16_t>::max(),
+                                        std::numeric_limits<std::int16_t>::max());
+        return TTData { std::uint64_t(key)
+            | std::uint64_t(move.flags | move.origin << 4 | move.target << 10) << 16
+            | std::uint64_t(std::uint16_t(score))                               << 32
+            | std::uint64_t(std::uint8_t(depth))                                << 48
+            | std::uint64_t(flag & 0x3)                                         << 56
+            | std::uint64_t(gen  & 0x3F)                                        << 58
+        };
+    }
+
+    // The moving piece is not stored, it is recovered from the origin square.
+    [[nodiscard]] inline auto GetMove(const GameState& Board) const noexcept {
+        const auto packed = std::uint16_t(data >> 16);
+        const auto origin = EnumSquare((packed >> 4) & 0x3F);
+        return Move {
+            .piece  = Board.PieceOn(origin),
+            .origin = origin,
+            .target = EnumSquare(packed >> 10),
+            .flags  = EnumMoveFlags(packed & 0xF)
+        };
+    }
+};
+
+struct alignas(64) TTBucket {
+    std::array<std::atomic<std::uint64_t>, HASH_BUCKET_SIZE> entries;
 };
 
 class TranspositionTable final {
 public:
+    TranspositionTable(std::size_t mb=HASH_TABLE_MB) { Resize(mb); }
+
+    // Mate scores count plies from the root. They are stored counted from this node and
+    // turned back on probing, so a mate reached by another path keeps its right distance.
+    inline auto Record(GameState& Board, int flag, int score, Move best, int depth, int ply) noexcept {
+        const auto key = std::uint16_t(Board.hash);
+        score = score >  HASH_MATE_BOUND ? score + ply :
+                score < -HASH_MATE_BOUND ? score - ply : score;
+        auto& bucket = GetBucket(Board.hash);
 
-    inline auto Record(GameState& Board, int flag, int score, Move best, int depth) noexcept {
-        TTData& Entry = table[Board.hash % HASH_TABLE_SIZE];
+        auto replace = &bucket.entries[0]; auto worst = std::numeric_limits<int>::max();
+        for (auto& slot: bucket.entries) {
+            const auto Entry = TTData { slot.load(std::memory_order_relaxed) };
 
-        if (Entry.hash == Board.hash && Entry.depth > depth)
-            return;
+            if (Entry.data && Entry.Key() == key) {
+                if (Entry.Depth() > depth && Entry.Gen() == generation) return;
+                replace = &slot; break;
+            }
 
-        Entry.hash  = Board.hash;
-        Entry.score = score;
-        Entry.move  = best;
-        Entry.flag  = flag;
-        Entry.depth = depth;
+            // Prefer overwriting empty, then old, then shallow entries.
+            const auto age   = (generation - Entry.Gen()) & 0x3F;
+            const auto worth = Entry.data ? Entry.Depth() - 8*age : -1;
+            if (worth < worst) worst = worth, replace = &slot;
+        }
+
+        replace->store(TTData::Pack(key, best, score, depth, flag, generation).data,
+                       std::memory_order_relaxed);
     }
 
-    inline auto Probe(GameState& Board, int alpha, int beta, int depth) noexcept {
-        TTData& Entry = table[Board.hash % HASH_TABLE_SIZE];
+    // One bucket scan for both answers: the score when the entry is enough for a cutoff
+    // (0xDEAD otherwise), and its move in `hash_move` (an empty move on a miss).
+    inline auto Probe(GameState& Board, int alpha, int beta, int depth, int ply, Move& hash_move) noexcept {
+        const auto Entry = Find(Board);
+        hash_move = Entry.data ? Entry.GetMove(Board)
+                               : Move { EnumPiece(0), EnumSquare(0), EnumSquare(0), EnumMoveFlags(0) };
 
-        if (Entry.hash == Board.hash) {
-            if (Entry.depth >= depth)
-                return (Entry.flag == HashExact) ?  Entry.score :
-                       (Entry.flag == HashAlpha  && Entry.score <= alpha) ? alpha :
-                       (Entry.flag == HashBeta   && Entry.score >= beta ) ? beta  :
-                       0xDEAD;
+        if (Entry.data && Entry.Depth() >= depth) {
+            auto score = int(Entry.Score());
+            score = score >  HASH_MATE_BOUND ? score - ply :
+                    score < -HASH_MATE_BOUND ? score + ply : score;
+            return (Entry.Flag() == HashExact) ? score :
+                   (Entry.Flag() == HashAlpha  && score <= alpha) ? alpha :
+                   (Entry.Flag() == HashBeta   && score >= beta ) ? beta  :
+                   0xDEAD;
         } return 0xDEAD;
     }
 
     inline auto GetBestMove(GameState& Board) noexcept  {
-        TTData& Entry = table[Board.hash % HASH_TABLE_SIZE];
-        if (Entry.hash) return Entry.move;
+        const auto Entry = Find(Board);
+        if (Entry.data) return Entry.GetMove(Board);
         else return Move { EnumPiece(0), EnumSquare(0), EnumSquare(0), EnumMoveFlags(0) };
     }
 
-    inline auto Clear() noexcept { std::memset(&table[0], 0, sizeof(table)); }
+    inline void Resize(std::size_t mb) noexcept {
+        mb = std::clamp<std::size_t>(mb, 1, HASH_TABLE_MAX_MB);
+        buckets = (mb << 20) / sizeof(TTBucket);
+        table.reset(new TTBucket[buckets]);
+        Clear();
+    }
+
+    inline void Clear() noexcept {
+        for (std::size_t index = 0; index < buckets; ++index)
+            for (auto& slot: table[index].entries)
+                slot.store(0, std::memory_order_relaxed);
+        generation = 0;
+    }
+
+    // Called once per `go`: entries from older searches become cheaper to replace.
+    inline void NewSearch() noexcept { generation = (generation + 1) & 0x3F; }
 
 private:
-    std::array<TTData, HASH_TABLE_SIZE> table { };
+    std::unique_ptr<TTBucket[]> table;
+    std::size_t                 buckets    = 0;
+    int                         generation = 0;
+
+    // Multiply-shift maps the hash onto [0, buckets) without a division, using its
+    // high bits, while the entry key is taken from the low 16 bits.
+    [[nodiscard]] inline TTBucket& GetBucket(std::uint64_t hash) noexcept {
+        return table[(static_cast<unsigned __int128>(hash) * buckets) >> 64];
+    }
+
+    [[nodiscard]] inline TTData Find(GameState& Board) noexcept {
+        const auto key = std::uint16_t(Board.hash);
+        for (auto& slot: GetBucket(Board.hash).entries) {
+            const auto Entry = TTData { slot.load(std::memory_order_relaxed) };
+            if (Entry.data && Entry.Key() == key) return Entry;
+        } return TTData { 0 };
+    }
 };
@@ -6,15 +6,20 @@
 #include "Search.hpp"
 #include "Utils.hpp"
 #include "Move.hpp"
+#include "NNUE.hpp"
+#include "TimeManager.hpp"
 
 #include <random>
 #include <chrono>
 #include <future>
 #include <atomic>
-#include <chrono>
+#include <thread>
+#include <vector>
 
 using namespace std::chrono_literals;
 
+#define MAX_THREADS 256
+
 namespace thread {
     static std::future<void> search;
 }
@@ -25,6 +30,17 @@ public:
     static void Init() {
         std::cout << "id name chess-engine" << std::endl;
         std::cout << "id name hab"          << std::endl;
+        std::cout << "option name Hash type spin default " << HASH_TABLE_MB
+                  << " min 1 max " << HASH_TABLE_MAX_MB << std::endl;
+        std::cout << "option name Threads type spin default 1 min 1 max "
+                  << MAX_THREADS << std::endl;
+        std::cout << "option name Ponder type check default false" << std::endl;
+        std::cout << "option name MoveOverhead type spin default " << MOVE_OVERHEAD
+                  << " min 0 max 5000" << std::endl;
+        std::cout << "option name EvalCacheKB type spin default " << EVAL_CACHE_KB
+                  << " min 0 max " << EVAL_CACHE_MAX_KB << std::endl;
+        std::cout << "option name UseNNUE type check default false" << std::endl;
+        std::cout << "option name EvalFile type string default " << NNUE_DEFAULT_FILE << std::endl;
         std::cout << "uciok"                << std::endl;
     }
 
@@ -42,20 +58,20 @@ public:
                 else if (cmd == "show"      ) { std::cout << Board << std::endl;      }
                 else if (cmd == "go"        ) { UCI::Go(Board, tokens);               }
                 else if (cmd == "isready"   ) { std::cout << "readyok" << std::endl;  }
+                else if (cmd == "setoption" ) { UCI::SetOption(tokens);               }
                 else if (cmd == "uci"       ) { UCI::Init();                          }
-                else if (cmd == "ucinewgame") { Board = GameState(STARTING_POSITION); }
+                else if (cmd == "ucinewgame") { UCI::NewGame(Board);                  }
                 else if (cmd == "quit"      ) { break;                                }
             } else {
                 if      (cmd == "stop"      ) { Search::stop = true;                  }
                 else if (cmd == "quit"      ) { Search::stop = true; break;           }
+                else if (cmd == "ponderhit" ) { TimeManager::PonderHit();             }
             }
             // else if (cmd == "debug") {}
-            // else if (cmd == "setoption") {}
             // else if (cmd == "register") {}
             // else if (cmd == "later") {}
             // else if (cmd == "name") {}
             // else if (cmd == "code") {}
-            // else if (cmd == "ponderhit") {}
             // else if (cmd == "id") {}
             // else if (cmd == "uciok") {}
             // else if (cmd == "readyok") {}
@@ -72,57 +88,157 @@ public:
             // else if (cmd == "min") {}
             // else if (cmd == "min") {}
         }
+        if (thread::search.valid()) thread::search.wait();
     }
 
 private:
     static inline std::atomic<bool> searching = false;
+    static inline int               threads   = 1;
 
     static void Go(GameState& Board, std::istringstream& tokens) {
+        SearchLimits Limits;
+        for (std::string token; tokens >> token; ) {
+            if      (token == "depth"    ) tokens >> Limits.depth;
+            else if (token == "movetime" ) tokens >> Limits.movetime;
+            else if (token == "nodes"    ) tokens >> Limits.nodes;
+            else if (token == "wtime"    ) tokens >> Limits.time[White];
+            else if (token == "btime"    ) tokens >> Limits.time[Black];
+            else if (token == "winc"     ) tokens >> Limits.inc[White];
+            else if (token == "binc"     ) tokens >> Limits.inc[Black];
+            else if (token == "movestogo") tokens >> Limits.movestogo;
+            else if (token == "infinite" ) Limits.infinite = true;
+            else if (token == "ponder"   ) Limits.ponder   = true;
+        }
 
-        thread::search = std::async(std::launch::async, [&]() { searching.store(true);
-            std::string token; tokens >> token;
+        // A bare `go` keeps searching to the historical fixed depth.
+        const auto timed = Limits.movetime || Limits.nodes || Limits.time[Board.to_play];
+        const auto depth = Limits.depth ? std::min(Limits.depth, MAX_DEPTH) :
+                           timed || Limits.infinite ? MAX_DEPTH : 8;
 
-            auto depth = 8;
-            if (token == "depth")
-                depth = (tokens >> token, std::atoi(token.c_str()));
+        if (NNUE::enabled) NNUE::Refresh(Board);
 
+        searching.store(true);
+        TimeManager::Start(Limits, Board.to_play);
+        thread::search = std::async(std::launch::async, [&Board, depth, Limits]() {
             Search::Init();
-            auto started  = std::chrono::steady_clock::now();
-            for (int current_depth = 1; current_depth <= depth; ++current_depth) {
-                auto score = Search::AlphaBetaNegamax(Board, current_depth);
-                auto finished = std::chrono::steady_clock::now();
+            HashTable.NewSearch();
 
+            std::vector<std::thread> helpers;
+            for (int id = 1; id < threads; ++id)
+                helpers.emplace_back(Search::Helper, Board, id);
 
-                auto ms = std::chrono::duration_cast
-                         <std::chrono::milliseconds>
-                         (finished-started).count();
-                auto sec = ms / 1000.00000f;
-                std::uint64_t nps = Search::nodes / sec;
+            // Bound is "lowerbound" or "upperbound" for a score outside the aspiration window.
+            const auto Report = [](int current_depth, int score, const char* bound) {
+                auto ms    = TimeManager::Elapsed();
+                auto nodes = Search::TotalNodes();
+                std::uint64_t nps = nodes * 1000 / std::max<std::int64_t>(ms, 1);
 
                 std::stringstream score_str;
                 if      (score >  10000) score_str << "mate "  << (CHECKMATE-score)/2;
                 else if (score < -10000) score_str << "mate -" << (CHECKMATE+score)/2;
                 else                     score_str << "cp "    << score;
+                if (bound)               score_str << " "      << bound;
 
+                // A fail low leaves no line at the root, the token is left off then.
+                const auto pv = PrincipalVariation::ToString();
                 std::cout <<  "info"
                           << " depth " << current_depth
                           << " score " << score_str.str()
-                          << " nodes " << Search::nodes
+                          << " nodes " << nodes
                           << " time "  << ms
                           << " nps "   << nps
-                          << " pv "    << PrincipalVariation::ToString()
+                          << (pv.empty() ? "" : " pv ") << pv
                           << std::endl;
+            };
+
+            for (int current_depth = 1, score = 0; current_depth <= depth; ++current_depth) {
+                // Past the first few plies the score rarely moves much between iterations,
+                // so search a narrow window around it first and widen it on either side
+                // until the score falls inside. Mate scores always get the full window.
+                auto delta = ASPIRATION_WINDOW, alpha = -INF, beta = INF;
+                if (current_depth >= ASPIRATION_DEPTH && std::abs(score) < 10000)
+                    alpha = std::max(score - delta, -INF), beta = std::min(score + delta, INF);
+
+                for (;;) {
+                    score = Search::AlphaBetaNegamax(Board, current_depth, alpha, beta);
+                    if (Search::stop) break;
 
-                if (Search::stop && not (Search::stop = false)) break;
+                    if (score <= alpha) {
+                        Report(current_depth, score, "upperbound");
+                        beta  = (alpha + beta) / 2;
+                        alpha = std::max(score - delta, -INF);
+                    } else if (score >= beta) {
+                        Report(current_depth, score, "lowerbound");
+                        beta  = std::min(score + delta, INF);
+                    } else break;
+                    delta += delta / 2;
+                }
+
+                // An interrupted iteration only reports through the moves it finished,
+                // which are already in the principal variation.
+                if (Search::stop && current_depth > 1) break;
+
+                Report(current_depth, score, nullptr);
+
+                TimeManager::Arm();
+                if (Search::stop || TimeManager::SoftStop(PrincipalVariation::GetBestMove(), score))
+                    break;
             }
 
-            std::cout << "besthash " << HashTable.GetBestMove(Board)      << std::endl;
-            std::cout << "bestmove " << PrincipalVariation::GetBestMove() << std::endl;
+            // Neither `go infinite` nor `go ponder` may answer before the GUI says stop, a
+            // ponder search that ran out of depth answers as soon as `ponderhit` arrives.
+            while ((Limits.infinite || TimeManager::Pondering()) && !Search::stop)
+                std::this_thread::sleep_for(1ms);
+
+            Search::stop = true;
+            for (auto& helper: helpers) helper.join();
+            Search::stop = false;
 
+            EvalCache::Flush(); MoveOrdering::Flush(); NodeStatistics::Flush();
+            std::cout << "info string evalcache probes " << EvalCache::Probes()
+                      << " hits " << EvalCache::HitRate() / 10.0 << "%" << std::endl;
+            std::cout << "info string ordering cutoffs " << MoveOrdering::Cutoffs()
+                      << " first " << MoveOrdering::FirstCutoffRate() / 10.0 << "%" << std::endl;
+            std::cout << "info string incheck saved " << NodeStatistics::Saved() << std::endl;
+
+            std::cout << "besthash " << HashTable.GetBestMove(Board) << std::endl;
+
+            // The GUI may answer `bestmove` with the next position and `go` right away,
+            // the engine has to be accepting commands again by then.
+            const auto best   = PrincipalVariation::GetBestMove();
+            const auto ponder = PrincipalVariation::GetPonderMove();
             searching.store(false);
+            if (ponder.piece) std::cout << "bestmove " << best << " ponder " << ponder << std::endl;
+            else              std::cout << "bestmove " << best << std::endl;
         });
     }
 
+    static void SetOption(std::istringstream& tokens) {
+        std::string token, name, value;
+        while (tokens >> token && token != "value") if (token != "name") name += token;
+        while (tokens >> token) value += token;
+
+        if (name == "Threads")
+            threads = std::clamp(std::atoi(value.c_str()), 1, MAX_THREADS);
+        else if (name == "Hash")
+            HashTable.Resize(std::max(std::atoi(value.c_str()), 1));
+        else if (name == "MoveOverhead")
+            TimeManager::overhead = std::clamp(std::atoi(value.c_str()), 0, 5000);
+        else if (name == "EvalCacheKB")
+            EvalCache::Resize(std::max(std::atoi(value.c_str()), 0));
+        else if (name == "UseNNUE")
+            NNUE::enabled = (value == "true"), EvalCache::Clear();
+        else if (name == "EvalFile") {
+            if (NNUE::Load(value)) EvalCache::Clear();
+            else std::cout << "info string could not load " << value << ", keeping current network" << std::endl;
+        }
+    }
+
+    static void NewGame(GameState& Board) {
+        Board = GameState(STARTING_POSITION);
+        HashTable.Clear();
+    }
+
     static void SetPosition(GameState& Board, std::istringstream& tokens) {
         std::string token; tokens >> token;
         if (token == "startpos")
@@ -160,7 +276,8 @@ private:
         for (auto move_index = 0; move_index < nmoves; move_index++) {
             auto move = move_list[move_index];
             if (uci_origin == move.origin && uci_target == move.target) {
-                #define MAKE_MOVE return Move::Make<Color>(Board, move);
+                UndoState Undo;
+                #define MAKE_MOVE return Move::Make<Color>(Board, move, Undo);
                 if (uci_promotion) {
                     auto promotion = move.flags & 0b1011;
                     if (uci_promotion == 'n' && promotion == PromotionKnight) MAKE_MOVE;
@@ -91,6 +91,17 @@ public:
         return hash;
     }
 
+    // Same piece keys restricted to pawns, so that it only changes on pawn moves,
+    // pawn captures and promotions.
+    [[nodiscard]] static inline auto PawnHash(GameState& Board) noexcept {
+        std::uint64_t hash = 0ULL;
+        for (auto set = Board[Pawns] & Board[White]; set; )
+            hash ^= Keys.Piece[Pawns-2][Utils::PopLS1B(set)];
+        for (auto set = Board[Pawns] & Board[Black]; set; )
+            hash ^= Keys.Piece[Pawns+6-2][Utils::PopLS1B(set)];
+        return hash;
+    }
+
 private:
      static const inline auto Keys = Generator::ZobristKeys::Get();
 
@@ -7,6 +7,8 @@
 #include "Search.hpp"
 #include "MoveOrdering.hpp"
 #include "TranspositionTable.hpp"
+#include "EvalKernels.hpp"
+#include "AttackMap.hpp"
 
 #include <algorithm>
 #include <iostream>
@@ -29,11 +31,197 @@
 #define WIKI_POS_5     "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8"
 #define KILLER         "rnbqkb1r/pp1p1pPp/8/2p1pP2/1P1P4/3P3P/P1P1P3/RNBQKBNR w KQkq e6 0 1"
 
+// Perft throughput on the reference positions, build with and without USE_MAKE_UNMAKE
+// (Move.hpp) to compare copy-make against make/unmake.
+static void Bench() noexcept {
+    const std::array<std::pair<const char*, int>, 4> positions {{
+        { STARTING_POSITION, 6 }, { KIWIPETE, 5 }, { WIKI_POS_4, 5 }, { WIKI_POS_5, 5 }
+    }};
+
+    std::uint64_t nodes = 0;
+    auto started = std::chrono::steady_clock::now();
+    for (auto [fen, depth]: positions) {
+        GameState Board(fen);
+        nodes += Perft::Run(Board, depth);
+    }
+    auto finished = std::chrono::steady_clock::now();
+
+    auto sec = std::chrono::duration<float>(finished-started).count();
+    std::cout << "[bench][" << nodes << "][" << nodes/sec/1000000 << "Mnps]\n";
+}
+
+// Evaluation popcount kernels on random attack batches: checks that every kernel agrees
+// with the scalar reference, then times each of them.
+static void KernelBench() noexcept {
+    std::mt19937_64 random(0xC0FFEE);
+    std::vector<AttackBatch> batches(4096);
+    std::vector<std::pair<Bitboard, Bitboard>> masks(batches.size());
+    for (auto i = 0U; i < batches.size(); ++i) {
+        batches[i].size = 1 + random() % (ATTACK_BATCH_SIZE-1);
+        for (auto j = 0; j < batches[i].size; ++j)
+            batches[i].attacks[j] = random() & random();
+        masks[i] = { random() | random(), random() & random() };
+    }
+
+    const std::array<std::pair<const char*, EvalKernels::Kernel>, 2> kernels {{
+        { "scalar", EvalKernels::Scalar },
+        #if defined(EVAL_KERNELS_X86)
+        { "avx2",   __builtin_cpu_supports("avx2") ? EvalKernels::AVX2 : nullptr }
+        #endif
+    }};
+
+    std::cout << "[kernels][dispatch " << EvalKernels::Name() << "]\n";
+    for (auto [name, kernel]: kernels) {
+        if (!kernel) continue;
+        for (auto i = 0U; i < batches.size(); ++i) {
+            EvalKernels::Counts mobility, attacks, ref_mobility, ref_attacks;
+            kernel(batches[i], masks[i].first, masks[i].second, mobility, attacks);
+            EvalKernels::Scalar(batches[i], masks[i].first, masks[i].second, ref_mobility, ref_attacks);
+            if (!std::equal(mobility.begin(), mobility.begin()+batches[i].size, ref_mobility.begin())
+            ||  !std::equal(attacks .begin(), attacks .begin()+batches[i].size, ref_attacks .begin()))
+                std::cout << "[kernels][" << name << "][mismatch on batch " << i << "]\n";
+        }
+
+        constexpr auto Passes = 2000;
+        std::uint64_t checksum = 0;
+        auto started = std::chrono::steady_clock::now();
+        for (auto pass = 0; pass < Passes; ++pass)
+            for (auto i = 0U; i < batches.size(); ++i) {
+                EvalKernels::Counts mobility, attacks;
+                kernel(batches[i], masks[i].first, masks[i].second, mobility, attacks);
+                checksum += mobility[0] + attacks[batches[i].size-1];
+            }
+        auto finished = std::chrono::steady_clock::now();
+
+        auto ns = std::chrono::duration<double, std::nano>(finished-started).count();
+        std::cout << "[kernels][" << name << "][" << ns / (Passes * batches.size())
+                  << "ns/batch][checksum " << checksum << "]\n";
+    }
+}
+
+// Slider lookups on random squares and occupancies: checks that PEXT and magic indexing
+// agree, then times both of them. Then the same for whole-set attack maps, AttackMap
+// kernels against the union of per-square lookups.
+static void SliderBench() noexcept {
+    std::mt19937_64 random(0xC0FFEE);
+    std::vector<std::pair<EnumSquare, Bitboard>> queries(1 << 16);
+    for (auto& [square, occupancy]: queries)
+        square = EnumSquare(random() % 64), occupancy = random() & random();
+
+    using Lookup = Bitboard (*)(EnumSquare, Bitboard) noexcept;
+    const std::array<std::pair<const char*, Lookup>, 2> backends {{
+        { "magic", [](EnumSquare square, Bitboard occupancy) noexcept -> Bitboard {
+            return GetAttack<Bishops>::Magic(square, occupancy) | GetAttack<Rooks>::Magic(square, occupancy); } },
+        #if defined(SLIDERS_PEXT)
+        { "pext",  __builtin_cpu_supports("bmi2") ? Lookup([](EnumSquare square, Bitboard occupancy) noexcept -> Bitboard {
+            return GetAttack<Bishops>::Pext(square, occupancy) | GetAttack<Rooks>::Pext(square, occupancy); }) : nullptr }
+        #endif
+    }};
+
+    std::cout << "[sliders][dispatch " << SliderBackend::Name() << "]\n";
+    for (auto [name, lookup]: backends) {
+        if (!lookup) continue;
+        for (auto [square, occupancy]: queries)
+            if (lookup(square, occupancy) != GetAttack<Queens>::On(square, occupancy)) {
+                std::cout << "[sliders][" << name << "][mismatch on " << square << "]\n"; break;
+            }
+
+        constexpr auto Passes = 200;
+        Bitboard checksum = 0;
+        auto started = std::chrono::steady_clock::now();
+        for (auto pass = 0; pass < Passes; ++pass)
+            for (auto [square, occupancy]: queries)
+                checksum ^= lookup(square, occupancy ^ checksum);
+        auto finished = std::chrono::steady_clock::now();
+
+        auto ns = std::chrono::duration<double, std::nano>(finished-started).count();
+        std::cout << "[sliders][" << name << "][" << ns / (Passes * queries.size())
+                  << "ns/queen][checksum " << checksum << "]\n";
+    }
+
+    // A bishop pair, a rook pair and a queen among random blockers.
+    std::vector<std::array<Bitboard, 3>> sets(1 << 12);
+    for (auto& [diagonal, orthogonal, empty]: sets) {
+        diagonal = orthogonal = 0;
+        for (auto i = 0; i < 2; ++i) diagonal   |= 1ULL << (random() % 64);
+        for (auto i = 0; i < 2; ++i) orthogonal |= 1ULL << (random() % 64);
+        const auto queen = 1ULL << (random() % 64);
+        diagonal |= queen, orthogonal |= queen;
+        empty = ~((random() & random()) | diagonal | orthogonal);
+    }
+
+    const auto PerSquare = [](Bitboard diagonal, Bitboard orthogonal, Bitboard empty) noexcept {
+        Bitboard attacks = 0;
+        while (diagonal)   attacks |= GetAttack<Bishops>::On(Utils::PopLS1B(diagonal),   ~empty);
+        while (orthogonal) attacks |= GetAttack<Rooks  >::On(Utils::PopLS1B(orthogonal), ~empty);
+        return attacks;
+    };
+    const std::array<std::pair<const char*, AttackMap::Kernel>, 3> kernels {{
+        { "per-square", PerSquare },
+        { "kogge-stone scalar", AttackMap::Scalar },
+        #if defined(ATTACK_MAP_X86)
+        { "kogge-stone avx2", __builtin_cpu_supports("avx2") ? AttackMap::AVX2 : nullptr }
+        #endif
+    }};
+
+    std::cout << "[attackmap][dispatch " << AttackMap::Name() << "]\n";
+    for (auto [name, kernel]: kernels) {
+        if (!kernel) continue;
+        for (auto [diagonal, orthogonal, empty]: sets)
+            if (kernel(diagonal, orthogonal, empty) != PerSquare(diagonal, orthogonal, empty)) {
+                std::cout << "[attackmap][" << name << "][mismatch]\n"; break;
+            }
+
+        constexpr auto Passes = 2000;
+        Bitboard checksum = 0;
+        auto started = std::chrono::steady_clock::now();
+        for (auto pass = 0; pass < Passes; ++pass)
+            for (auto [diagonal, orthogonal, empty]: sets)
+                checksum += kernel(diagonal, orthogonal, empty | (checksum & 1));
+        auto finished = std::chrono::steady_clock::now();
+
+        auto ns = std::chrono::duration<double, std::nano>(finished-started).count();
+        std::cout << "[attackmap][" << name << "][" << ns / (Passes * sets.size())
+                  << "ns/map][checksum " << checksum << "]\n";
+    }
+}
+
+// chess-engine [bench | kernels | sliders | <depth> | perft <depth> [fen] | divide <depth> [fen] |
+//               parallel <depth> <threads> <split> [fen] |
+//               suite <file.epd> [max_depth]] [hash <mb>]
 int main(int argc, char* argv[]) { (void)argc; (void)argv;
+    NNUE::Init();
+    EvalCache::Resize(EVAL_CACHE_KB);
+
     if (argc != 1) {
+        for (auto arg = 1; arg+1 < argc; ++arg)
+            if (std::strcmp(argv[arg], "hash") == 0)
+                Perft::Hash(std::atoi(argv[arg+1])), argc = arg;
+
+        const auto fen = [&](int from) {
+            std::string fen;
+            for (auto arg = from; arg < argc; ++arg) fen += (fen.empty() ? "" : " ") + std::string(argv[arg]);
+            return fen.empty() ? std::string(STARTING_POSITION) : fen;
+        };
+
         GameState Board(STARTING_POSITION);
         if (std::strcmp(argv[1], "pgo") == 0)
             Perft::Run(Board, 6), (void)Search::AlphaBetaNegamax(Board, 4);
+        else if (std::strcmp(argv[1], "bench") == 0) Bench();
+        else if (std::strcmp(argv[1], "kernels") == 0) KernelBench();
+        else if (std::strcmp(argv[1], "sliders") == 0) SliderBench();
+        else if (std::strcmp(argv[1], "perft")  == 0 && argc > 2) {
+            GameState Position(fen(3)); Perft::Run(Position, std::atoi(argv[2]));
+        }
+        else if (std::strcmp(argv[1], "divide") == 0 && argc > 2) {
+            GameState Position(fen(3)); Perft::Divide(Position, std::atoi(argv[2]));
+        }
+        else if (std::strcmp(argv[1], "parallel") == 0 && argc > 4) {
+            GameState Position(fen(5));
+            Perft::Parallel(Position, std::atoi(argv[2]), std::atoi(argv[3]), std::atoi(argv[4]));
+        }
+        else if (std::strcmp(argv[1], "suite")  == 0 && argc > 2)
+            return Perft::Suite(argv[2], argc > 3 ? std::atoi(argv[3]) : MAX_DEPTH) ? 0 : 1;
         else Perft::Run(Board, std::atoi(argv[1]));
         return 0;
     }